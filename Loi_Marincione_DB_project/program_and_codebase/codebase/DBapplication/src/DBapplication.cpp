@@ -32,10 +32,21 @@
 #include "DButils/CLprinter.h"
 #include "manager/dbhierarchy/Dbnode.h"
 #include "manager/DBmanager.h"
+#include "manager/graph/SnapshotTool.h"
+#include "manager/PathfinderCheck.h"
 
 int main(int argc, char** argv)
 {
     std::ios_base::sync_with_stdio(false);
+
+    // "DBapplication --snapshot ..." only builds or checks a graph snapshot file, see SnapshotTool.h
+    if (argc > 1 && std::string(argv[1]) == "--snapshot")
+        return paths::snapshotTool(argc - 2, argv + 2, CONNECT_QUERY);
+
+    // "DBapplication --selfcheck ..." runs concurrent searches against serial ones, see PathfinderCheck.h
+    if (argc > 1 && std::string(argv[1]) == "--selfcheck")
+        return pathfinderCheck(argc - 2, argv + 2, CONNECT_QUERY);
+
     ShowWindow(GetConsoleWindow(), SW_MAXIMIZE);
     SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), ENABLE_PROCESSED_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
 
@@ -0,0 +1,184 @@
+#pragma once
+#include "libpq-fe.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include "queries.h"
+#include "PreparedStatements.h"
+
+namespace query
+{
+
+/**
+ * Runs a batch of independent prepared statements through libpq pipeline mode: all of them are sent
+ * at once, closed by a single sync, and their results are read back in order as they arrive, so the
+ * batch costs one network latency instead of one per statement.
+ *
+ * Only statements whose values are all known up front belong in a batch, none of them sees the others'
+ * results. Unlike query::executeQuery, the statements up to the sync share a single implicit transaction:
+ * one that fails aborts it, and the server skips the rest (PGRES_PIPELINE_ABORTED). The statements without
+ * a result then run again one by one through the registry, unless the connection could not leave pipeline mode.
+ */
+class pipeline
+{
+public:
+    pipeline(PGconn* connection, preparedStatements& statements) : connection(connection), statements(statements) {}
+
+    ~pipeline()
+    {
+        for (auto res : results)
+            PQclear(res);
+    }
+
+    pipeline(pipeline const&) = delete;
+    pipeline& operator=(pipeline const&) = delete;
+
+    /**
+     * Queues a statement for the next run().
+     *
+     * \param stmt      The statement, one of query::statements.
+     * \param values    One text value per parameter, in order.
+     * \return          Index of the statement, its result is take(index).
+     */
+    size_t add(statement const& stmt, std::vector<std::string> values)
+    {
+        queued.push_back({ &stmt, std::move(values) });
+        results.push_back(nullptr);
+        return queued.size() - 1;
+    }
+
+    /**
+     * Sends every queued statement and collects their results.
+     *
+     * \return          True if all of them ran successfully, false also if the connection was left in pipeline mode.
+     */
+    bool run()
+    {
+        for (auto const& entry : queued)
+        {
+            if (!statements.prepare(*entry.stmt))
+                return false;
+        }
+
+        if (!queued.empty() && PQenterPipelineMode(connection) == 1)
+        {
+            size_t sent = 0;
+            for (; sent < queued.size(); ++sent)
+            {
+                std::vector<const char*> params;
+                for (auto const& value : queued[sent].values)
+                    params.push_back(value.c_str());
+
+                if (PQsendQueryPrepared(connection, queued[sent].stmt->name, queued[sent].stmt->paramCount, params.data(), nullptr, nullptr, static_cast<int>(queued[sent].stmt->format)) != 1)
+                    break;
+                ++traffic.statements;
+            }
+
+            if (PQpipelineSync(connection) == 1)
+            {
+                ++traffic.roundTrips;
+                collect(sent);
+            }
+            else
+                drain();
+
+            // Still in pipeline mode the synchronous fallback below would fail too, and so would every later query
+            if (PQexitPipelineMode(connection) != 1)
+            {
+                std::cerr << "Could not leave pipeline mode: " << PQerrorMessage(connection) << "\n";
+                return false;
+            }
+        }
+
+        bool allRan = true;
+
+        for (size_t i = 0; i < queued.size(); ++i)
+        {
+            if (results[i] != nullptr)
+                continue;
+
+            if (!statements.execute(*queued[i].stmt, queued[i].values, results[i]))
+            {
+                PQclear(results[i]);
+                results[i] = nullptr;
+                allRan = false;
+            }
+        }
+
+        return allRan;
+    }
+
+    /**
+     * Hands over the result of a statement, the caller clears it.
+     *
+     * \param index     As returned by add().
+     * \return          The result, nullptr if the statement failed or was already taken.
+     */
+    PGresult* take(size_t index)
+    {
+        PGresult* res = results[index];
+        results[index] = nullptr;
+        return res;
+    }
+
+    size_t size() const { return queued.size(); }
+
+private:
+    struct entry
+    {
+        statement const* stmt;
+        std::vector<std::string> values;
+    };
+
+    /**
+     * Reads the results of the first sent statements and the sync closing them, the failed ones are left empty.
+     */
+    void collect(size_t sent)
+    {
+        for (size_t i = 0; i < sent; ++i)
+        {
+            PGresult* res = PQgetResult(connection);
+            if (res == nullptr)
+                break;
+
+            // PGRES_PIPELINE_ABORTED for the ones following a failure
+            if (auto status = PQresultStatus(res); statusFailed(status) || status == PGRES_PIPELINE_ABORTED)
+            {
+                PQclear(res);
+            }
+            else
+            {
+                traffic.bytesReceived += resultBytes(res);
+                results[i] = res;
+            }
+
+            // Every statement's results end with a null
+            while (PGresult* extra = PQgetResult(connection))
+                PQclear(extra);
+        }
+
+        drain();
+    }
+
+    /**
+     * Throws away results until the sync or a null, what is left keeps the connection from leaving pipeline mode.
+     */
+    void drain()
+    {
+        while (PGresult* res = PQgetResult(connection))
+        {
+            bool const synced = PQresultStatus(res) == PGRES_PIPELINE_SYNC;
+            PQclear(res);
+            if (synced)
+                break;
+        }
+    }
+
+    PGconn* connection;
+    preparedStatements& statements;
+
+    std::vector<entry> queued;
+    std::vector<PGresult*> results;
+};
+
+}
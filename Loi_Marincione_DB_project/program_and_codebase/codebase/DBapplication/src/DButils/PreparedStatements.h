@@ -0,0 +1,205 @@
+#pragma once
+#include "libpq-fe.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "queries.h"
+
+namespace query
+{
+
+/**
+ * A fixed SQL shape, its values are passed as $1..$n instead of being spliced into the text.
+ */
+struct statement
+{
+    const char* name;
+    const char* sql;
+    int paramCount;
+    resultFormat format = resultFormat::TEXT;
+};
+
+/**
+ * The statements run on the hot paths of the application. A session keeps one plan per name,
+ * so the names are unique across the program.
+ */
+namespace statements
+{
+    inline constexpr statement CLIENT_COMPANY_NAME{ "client_company_name",
+        "SELECT co.\"Name\" FROM public.\"Company\" as co, public.\"Client\" as cl WHERE co.\"ID\" = $1 AND cl.\"CompanyCode\" = $1", 1 };
+
+    inline constexpr statement COMPANY_CENTERS{ "company_centers",
+        "SELECT coi.\"Name\", coi.\"ID\", coi.\"Type\" FROM public.\"CenterOfInterest\" as coi WHERE coi.\"CompanyCode\" = $1", 1 };
+
+    inline constexpr statement CENTER_PLACE{ "center_place",
+        "SELECT \"CenterOfInterest\".\"PlaceCode\" FROM public.\"CenterOfInterest\" WHERE \"CenterOfInterest\".\"ID\" = $1;", 1, resultFormat::BINARY };
+
+    // Places of a batch of Centers of Interest, $1 being an array literal of their IDs ("{1,2,3}")
+    inline constexpr statement CENTER_PLACES{ "center_places",
+        "SELECT \"ID\", \"PlaceCode\" FROM public.\"CenterOfInterest\" WHERE \"ID\" = ANY($1);", 1, resultFormat::BINARY };
+
+    // Every Center of Interest with its Place, of one company or of the whole DB, by ID
+    inline constexpr statement COMPANY_CENTER_PLACES{ "company_center_places",
+        "SELECT \"ID\", \"PlaceCode\" FROM public.\"CenterOfInterest\" WHERE \"CompanyCode\" = $1 ORDER BY \"ID\";", 1, resultFormat::BINARY };
+
+    inline constexpr statement ALL_CENTER_PLACES{ "all_center_places",
+        "SELECT \"ID\", \"PlaceCode\" FROM public.\"CenterOfInterest\" ORDER BY \"ID\";", 0, resultFormat::BINARY };
+
+    inline constexpr statement COMPANY_ROUTES{ "company_routes",
+        "SELECT ro.* FROM \"Route\" as ro JOIN \"ViewPrivilege\" as view ON (ro.\"ID\" = view.\"RouteCode\") WHERE view.\"CompCode\" = $1", 1 };
+
+    inline constexpr statement ROUTES_FROM_CENTER{ "routes_from_center",
+        "SELECT ro.\"ID\", ro.\"ToCode\" FROM public.\"Route\" as ro JOIN public.\"ViewPrivilege\" as vi ON (ro.\"ID\" = vi.\"RouteCode\")"
+        " WHERE ro.\"FromCode\" = $1 AND vi.\"CompCode\" = $2", 2 };
+
+    inline constexpr statement ROUTE_CONTAINS{ "route_contains",
+        "SELECT * FROM public.\"Contains\" WHERE \"Contains\".\"RouteCode\" = $1 ORDER BY \"Contains\".\"Order\"", 1 };
+
+    inline constexpr statement ROUTE_LEGS{ "route_legs",
+        "SELECT ct.\"PlaceACode\" as \"Place A\", ct.\"PlaceBCode\" as \"Place B\", ct.\"AllowedVehicle\""
+        " FROM \"Contains\" as ct WHERE ct.\"RouteCode\" = $1 ORDER BY ct.\"Order\" ASC", 1 };
+
+    inline constexpr statement CENTER_STOCK{ "center_stock",
+        "SELECT \"Product\".\"Name\", \"Product\".\"ID\", \"Stock\".\"Qty\""
+        " FROM \"Stock\" JOIN \"Product\" ON(\"Stock\".\"ProdCode\" = \"Product\".\"ID\") WHERE \"Stock\".\"CoICode\" = $1", 1 };
+
+    // Free vehicles of a type at a depot: owned by a company, by anyone, or one connection away (but the one in use)
+    inline constexpr statement FREE_OWN_VEHICLES{ "free_own_vehicles",
+        "SELECT * FROM \"NotCurrentlyUsed\" as nsd WHERE nsd.\"Depot\" = $1 AND nsd.\"Type\" = $2 AND nsd.\"Owner\" = $3", 3 };
+
+    inline constexpr statement FREE_VEHICLES{ "free_vehicles",
+        "SELECT * FROM \"NotCurrentlyUsed\" as nsd WHERE nsd.\"Depot\" = $1 AND nsd.\"Type\" = $2", 2 };
+
+    inline constexpr statement FREE_NEIGHBOUR_VEHICLES{ "free_neighbour_vehicles",
+        "SELECT nsd.* FROM \"NotCurrentlyUsed\" as nsd JOIN \"Connection\" as cn ON (nsd.\"Depot\" = cn.\"PlaceA\" AND nsd.\"Type\" = cn.\"AllowedVehicles\")"
+        " WHERE cn.\"PlaceB\" = $1 AND cn.\"AllowedVehicles\" = $2 AND nsd.\"ID\" <> $3", 3 };
+}
+
+/**
+ * Prepares statements on a connection the first time they are run (PQprepare) and runs them by name afterwards
+ * (PQexecPrepared), so the server parses and plans each shape once per session and values never become SQL.
+ *
+ * Prepared statements belong to the server session: a new backend behind the connection (PQreset(), a reconnect)
+ * is noticed from its PID and everything is prepared again, and a statement the server no longer knows is prepared
+ * again and retried once. Registries sharing a connection may prepare the same statement, the second finds it there.
+ */
+class preparedStatements
+{
+public:
+    explicit preparedStatements(PGconn* connection) : connection(connection) {}
+
+    /**
+     * Runs a statement, preparing it first if this session has not seen it yet.
+     *
+     * \param stmt      The statement, one of query::statements.
+     * \param values    One text value per parameter, in order.
+     * \param res       Pointer to a PGresult, results of the query will be dumped here
+     * \return          True if the statement ran successfully.
+     */
+    bool execute(statement const& stmt, std::vector<std::string> const& values, PGresult*& res)
+    {
+        if (static_cast<int>(values.size()) != stmt.paramCount)
+        {
+            std::cerr << "Statement " << stmt.name << " takes " << stmt.paramCount << " values, " << values.size() << " given.\n";
+            res = nullptr;
+            return false;
+        }
+
+        std::vector<const char*> params;
+        params.reserve(values.size());
+        for (auto const& value : values)
+            params.push_back(value.c_str());
+
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            if (!prepare(stmt))
+            {
+                res = nullptr;
+                return false;
+            }
+
+            res = PQexecPrepared(connection, stmt.name, stmt.paramCount, params.data(), nullptr, nullptr, static_cast<int>(stmt.format));
+            ++traffic.roundTrips;
+            ++traffic.statements;
+
+            if (!statusFailed(PQresultStatus(res)) && res != nullptr)
+            {
+                traffic.bytesReceived += resultBytes(res);
+                return true;
+            }
+
+            // Deallocated behind our back (DISCARD ALL, a pooler handing out another session): prepare it again
+            if (attempt == 0 && hasState(res, UNKNOWN_STATEMENT))
+            {
+                prepared.erase(stmt.name);
+                PQclear(res);
+                continue;
+            }
+
+            break;
+        }
+
+        std::cerr << "Query failed: " << PQerrorMessage(connection) << "\n";
+
+#ifdef _DEBUG
+        std::cerr << "Statement was: " << stmt.name << "\n";
+#endif // DEBUG
+
+        return false;
+    }
+
+    /**
+     * Prepares a statement on the current session unless it already is, without running it.
+     *
+     * \param stmt      The statement, one of query::statements.
+     * \return          True if the session has the statement.
+     */
+    bool prepare(statement const& stmt)
+    {
+        // A new backend knows none of our statements
+        if (int const pid = PQbackendPID(connection); pid != backendPid)
+        {
+            prepared.clear();
+            backendPid = pid;
+        }
+
+        if (prepared.find(stmt.name) != prepared.end())
+            return true;
+
+        PGresult* res = PQprepare(connection, stmt.name, stmt.sql, stmt.paramCount, nullptr);
+        ++traffic.roundTrips;
+
+        bool const ready = !(statusFailed(PQresultStatus(res)) || res == nullptr) || hasState(res, DUPLICATE_STATEMENT);
+        if (!ready)
+            std::cerr << "Could not prepare " << stmt.name << ": " << PQerrorMessage(connection) << "\n";
+
+        PQclear(res);
+
+        if (ready)
+            prepared.insert(stmt.name);
+
+        return ready;
+    }
+
+    // Statements prepared on the current session
+    size_t size() const { return prepared.size(); }
+
+private:
+    static constexpr const char* UNKNOWN_STATEMENT = "26000";        // invalid_sql_statement_name
+    static constexpr const char* DUPLICATE_STATEMENT = "42P05";      // duplicate_prepared_statement
+
+    static bool hasState(const PGresult* res, const char* sqlstate)
+    {
+        const char* state = res ? PQresultErrorField(res, PG_DIAG_SQLSTATE) : nullptr;
+        return state != nullptr && std::strcmp(state, sqlstate) == 0;
+    }
+
+    PGconn* connection;
+    int backendPid = 0;
+    std::unordered_set<std::string_view> prepared;  // names of query::statements and of the registered WKQueries, they outlive the registry
+};
+
+}
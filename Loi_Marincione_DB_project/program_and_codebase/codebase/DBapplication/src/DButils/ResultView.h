@@ -0,0 +1,174 @@
+#pragma once
+#include "libpq-fe.h"
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+namespace query
+{
+
+/**
+ * OIDs of the built-in types decoded below, fixed by PostgreSQL (pg_type.dat). Enums get an OID of
+ * their own in every DB, any other type is read as text.
+ */
+namespace types
+{
+    inline constexpr Oid INT8 = 20;
+    inline constexpr Oid INT2 = 21;
+    inline constexpr Oid INT4 = 23;
+    inline constexpr Oid FLOAT4 = 700;
+    inline constexpr Oid FLOAT8 = 701;
+}
+
+/**
+ * Decoders for single fields. Binary fields are in network byte order, text fields are parsed in place;
+ * a NULL, or a binary field of a type that is not a number, reads as 0.
+ */
+namespace decode
+{
+    inline uint64_t bigEndian(const char* data, int bytes)
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value = (value << 8) | static_cast<unsigned char>(data[i]);
+        return value;
+    }
+
+    inline int64_t integer(const char* data, int length, Oid type, bool binary)
+    {
+        if (!binary)
+        {
+            int64_t value = 0;
+            std::from_chars(data, data + length, value);
+            return value;
+        }
+
+        switch (type)
+        {
+        case types::INT2: return length == 2 ? static_cast<int16_t>(bigEndian(data, 2)) : 0;
+        case types::INT4: return length == 4 ? static_cast<int32_t>(bigEndian(data, 4)) : 0;
+        case types::INT8: return length == 8 ? static_cast<int64_t>(bigEndian(data, 8)) : 0;
+        default: return 0;
+        }
+    }
+
+    inline double real(const char* data, int length, Oid type, bool binary)
+    {
+        // Text fields are null terminated, strtod also takes "Infinity" and "NaN" as PostgreSQL writes them
+        if (!binary)
+            return length > 0 ? std::strtod(data, nullptr) : 0.0;
+
+        switch (type)
+        {
+        case types::FLOAT4:
+        {
+            if (length != 4)
+                return 0.0;
+            uint32_t const bits = static_cast<uint32_t>(bigEndian(data, 4));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        case types::FLOAT8:
+        {
+            if (length != 8)
+                return 0.0;
+            uint64_t const bits = bigEndian(data, 8);
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        default:
+            return static_cast<double>(integer(data, length, type, binary));
+        }
+    }
+}
+
+/**
+ * Typed, read-only access to a result, for the queries whose results are decoded rather than printed.
+ * Fields are decoded where they lie in the PGresult, nothing is copied or allocated; text and binary
+ * results read the same, but binary ones (see query::resultFormat) skip the parsing.
+ *
+ * The view does not own the result, it has to be used before the result is cleared.
+ * Enum values (binary or not) are their label, read them through text().
+ */
+class resultView
+{
+public:
+    /**
+     * A column read as T (int64_t, double or std::string_view), format and type are looked up once for the whole column.
+     * PGresult keeps every field apart and in wire order, so the column is walked through instead of being a contiguous array.
+     */
+    template<class T>
+    class column
+    {
+    public:
+        column(const PGresult* res, int index) : res(res), index(index), rows(res ? PQntuples(res) : 0),
+            type(rows ? PQftype(res, index) : 0), binary(rows && PQfformat(res, index) == 1) {}
+
+        T operator[](int row) const
+        {
+            const char* data = PQgetvalue(res, row, index);
+            int const length = PQgetlength(res, row, index);
+
+            if constexpr (std::is_same_v<T, std::string_view>)
+                return { data, static_cast<size_t>(length) };
+            else if constexpr (std::is_floating_point_v<T>)
+                return static_cast<T>(decode::real(data, length, type, binary));
+            else
+                return static_cast<T>(decode::integer(data, length, type, binary));
+        }
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = int;
+            using pointer = void;
+            using reference = T;
+
+            iterator(column const* owner, int row) : owner(owner), row(row) {}
+
+            T operator*() const { return (*owner)[row]; }
+            iterator& operator++() { ++row; return *this; }
+            bool operator==(iterator const& other) const { return row == other.row; }
+            bool operator!=(iterator const& other) const { return row != other.row; }
+
+        private:
+            column const* owner;
+            int row;
+        };
+
+        iterator begin() const { return { this, 0 }; }
+        iterator end() const { return { this, rows }; }
+        int size() const { return rows; }
+
+    private:
+        const PGresult* res;
+        int index;
+        int rows;
+        Oid type;
+        bool binary;
+    };
+
+    explicit resultView(const PGresult* res) : res(res) {}
+
+    int rows() const { return res ? PQntuples(res) : 0; }
+
+    template<class T>
+    column<T> get(int index) const { return { res, index }; }
+
+    int64_t integer(int row, int index) const { return get<int64_t>(index)[row]; }
+    double real(int row, int index) const { return get<double>(index)[row]; }
+    std::string_view text(int row, int index) const { return get<std::string_view>(index)[row]; }
+
+private:
+    const PGresult* res;
+};
+
+}
@@ -6,6 +6,7 @@
 #include <unordered_set>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <algorithm>
 #include "../defines/clicolors.h"
@@ -30,62 +31,84 @@ inline bool statusFailed(ExecStatusType status)
 namespace query
 {
 
-
 /**
- * Begins a SQL transaction and checks for possible errors.
- *
- * \param connection    Pointer to a Database Connection.
+ * Round trips made and bytes received through the helpers below, counted per thread since the program started.
+ * Take a copy before a piece of work and subtract it afterwards to know what the work cost.
  */
-static bool beginTransaction(PGconn* const& connection)
+struct wireCounters
 {
-    PGresult* res = PQexec(connection, "BEGIN");
+    uint64_t roundTrips = 0;
+    uint64_t bytesReceived = 0;     // field values of the results, the protocol overhead is not counted
+    uint64_t statements = 0;        // sent through executeQuery(), transaction control aside
+};
 
-    if (statusFailed(PQresultStatus(res)) || res == nullptr)
-    {
-        //Preprocessor defines in order to reduce code size.
-#ifdef _DEBUG
+inline thread_local wireCounters traffic;
 
-        std::cerr << "BEGIN command failed: " << PQerrorMessage(connection) << "\n";
+/**
+ * Sum of the lengths of every field value of a result.
+ */
+inline uint64_t resultBytes(const PGresult* res)
+{
+    uint64_t bytes = 0;
+    int const rows = PQntuples(res);
+    int const fields = PQnfields(res);
 
-#endif // DEBUG
-        return false;
-    }
-    return true;
+    for (int row = 0; row < rows; ++row)
+        for (int field = 0; field < fields; ++field)
+            bytes += PQgetlength(res, row, field);
+
+    return bytes;
 }
 
 /**
- * Closes and commits an SQL transaction, checking for possible errors.
+ * Sends a statement that returns no rows (BEGIN, ROLLBACK, ...) and clears its result.
  *
+ * \param command       CString with the statement.
  * \param connection    Pointer to a Database Connection.
  */
-static bool endTransaction(PGconn* const& connection)
+static bool executeCommand(const char* command, PGconn* const& connection)
 {
-    PGresult* res = PQexec(connection, "END");
-    if (statusFailed(PQresultStatus(res)) || res == nullptr)
-    {
-#ifdef _DEBUG
+    PGresult* res = PQexec(connection, command);
+    ++traffic.roundTrips;
 
-        std::cerr << "BEGIN command failed: " << PQerrorMessage(connection) << "\n";
+    bool const failed = statusFailed(PQresultStatus(res)) || res == nullptr;
+
+#ifdef _DEBUG
+    if (failed)
+        std::cerr << command << " command failed: " << PQerrorMessage(connection) << "\n";
+#endif // DEBUG
 
-#endif
-        return false;
-    }
     PQclear(res);
-    return true;
+    return !failed;
 }
 
+/**
+ * Format the server sends result fields in. TEXT is what the printers show, BINARY saves the server the
+ * formatting and us the parsing for results that are only decoded (see query::resultView).
+ */
+enum class resultFormat : int
+{
+    TEXT = 0,
+    BINARY = 1
+};
 
 /**
  * Executes a SQL query providing some safety checks for connection errors.
+ * Outside of a transaction scope the statement runs in autocommit: the server wraps it in a transaction
+ * of its own, so a single statement is atomic and costs one round trip.
  * 
  * \brief           Executes a SQL query
  * \param query     A CString containing an SQL query
  * \param res           Pointer to a PGresult, results of the query will be dumped here
  * \param connection    Pointer to a Database Connection.
+ * \param format        Format of the results, a BINARY query has to be a single statement.
  */
-static bool executeQuery(const char* query, PGresult*& res, PGconn* const& connection)
+static bool executeQuery(const char* query, PGresult*& res, PGconn* const& connection, resultFormat format = resultFormat::TEXT)
 {
-    res = PQexec(connection, query);
+    res = format == resultFormat::TEXT ? PQexec(connection, query)
+        : PQexecParams(connection, query, 0, nullptr, nullptr, nullptr, nullptr, static_cast<int>(format));
+    ++traffic.roundTrips;
+    ++traffic.statements;
 
     if (auto status = PQresultStatus(res); statusFailed(status) || res == nullptr)
     {
@@ -99,30 +122,93 @@ static bool executeQuery(const char* query, PGresult*& res, PGconn* const& conne
 
         return false;
     }
+
+    traffic.bytesReceived += resultBytes(res);
     return true;
 }
 
 /**
+ * Transaction scope: BEGIN when it is opened, COMMIT on commit(), ROLLBACK when it is left without one
+ * (an early return, a failed statement). Statements go through executeQuery() on the same connection in between.
  *
- *
- *  Provides a convenient way to execute a single query in a transaction block.
- *
- * \brief Executes a query wrapped in a transaction.
- * \param query         CString with the SQL query to be executed
- * \param res           Pointer to a PGresult, results of the query will be dumped here
- * \param connection    Pointer to a Database Connection.
+ * Only statements that have to commit together need one, a single statement is atomic on its own.
+ * A READ_ONLY_SNAPSHOT scope runs at REPEATABLE READ, READ ONLY: every statement sees the DB as it was at
+ * the first one, for reads that have to agree with each other. Leaving it without commit() is fine.
  */
-static bool atomicQuery(const char* query, PGresult*& res, PGconn* const& connection)
+class transaction
 {
-    bool status = false;
-    if (beginTransaction(connection))
+public:
+    enum class mode : char
     {
-        status = executeQuery(query, res, connection);
+        READ_WRITE,
+        READ_ONLY_SNAPSHOT
+    };
+
+    explicit transaction(PGconn* const& connection, mode kind = mode::READ_WRITE) : connection(connection)
+    {
+        open = executeCommand(kind == mode::READ_ONLY_SNAPSHOT ? "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY" : "BEGIN", connection);
     }
 
-    endTransaction(connection);
-    return status;
-}
+    ~transaction()
+    {
+        rollback();
+    }
+
+    transaction(transaction const&) = delete;
+    transaction& operator=(transaction const&) = delete;
+
+    /**
+     * False if BEGIN failed, statements would run in autocommit then.
+     */
+    bool isOpen() const { return open; }
+
+    /**
+     * Commits the transaction and closes the scope.
+     *
+     * \return  False if it was rolled back instead, a COMMIT after a failed statement is answered with a ROLLBACK.
+     */
+    bool commit()
+    {
+        if (!open)
+            return false;
+
+        open = false;
+        PGresult* res = PQexec(connection, "COMMIT");
+        ++traffic.roundTrips;
+
+        bool const committed = PQresultStatus(res) == PGRES_COMMAND_OK && std::string_view(PQcmdStatus(res)) == "COMMIT";
+        if (!committed)
+            std::cerr << "The transaction was rolled back: " << PQerrorMessage(connection) << "\n";
+
+        PQclear(res);
+        return committed;
+    }
+
+    /**
+     * Rolls the transaction back and closes the scope, nothing happens if it is already closed.
+     */
+    void rollback()
+    {
+        if (!open)
+            return;
+
+        open = false;
+        executeCommand("ROLLBACK", connection);
+    }
+
+private:
+    PGconn* connection;
+    bool open = false;
+};
+
+/**
+ * Read-only snapshot scope, see transaction.
+ */
+class readSnapshot : public transaction
+{
+public:
+    explicit readSnapshot(PGconn* const& connection) : transaction(connection, mode::READ_ONLY_SNAPSHOT) {}
+};
 
 
 /**
@@ -12,6 +12,9 @@
 #include <stack>
 #include "dbhierarchy/Dbnode.h"
 #include "../DButils/queries.h"
+#include "../DButils/PreparedStatements.h"
+#include "../DButils/Pipeline.h"
+#include "../DButils/ResultView.h"
 #include "../DButils/CLprinter.h"
 #include <cstdint>
 
@@ -31,9 +34,11 @@
 #include "queries/Function.h"
 #include "queries/Query.h"
 #include "queries/ParametrizedQuery.h"
+#include "queries/ReachabilityQuery.h"
 
 // I\O stuff
 #include <iostream>
+#include <chrono>
 #include <cctype>
 #include <conio.h>
 #include "../defines/DBkeys.h"
@@ -57,9 +62,10 @@ class DBmanager
 {
 public:
 
-	explicit DBmanager(PGconn*& connection) : res(nullptr), conn(connection), selected_dir(0, 0, 0), 
-		curPos(0), selected_wk(0), menu_options({ "Show Directory Tree", "Query Tool", "Well Known Queries", "Pathfinder Utility", "See Routes", "Schedule Shipments"}), selected_menu_opt(0), pather(conn, res)
+	explicit DBmanager(PGconn*& connection) : res(nullptr), conn(connection), prepared(connection), selected_dir(0, 0, 0), 
+		curPos(0), selected_wk(0), menu_options({ "Show Directory Tree", "Query Tool", "Well Known Queries", "Pathfinder Utility", "See Routes", "Schedule Shipments"}), selected_menu_opt(0), pather(conn)
 	{
+		startAction("Start-up");
 		root = Dbnode<NODE::ROOT>("ROOT");
 		using uint = uint64_t;
 		using lint = int64_t;
@@ -195,7 +201,7 @@ public:
 
 			well_knowns.emplace_back(std::make_unique<ParametrizedQuery>("Get Parked Vehicles",
 				"WITH temp_vals (time_start, time_end, depot) as ("
-				"values (TIMESTAMP %, TIMESTAMP %, CAST(% AS integer))"
+				"values (CAST(% AS timestamp), CAST(% AS timestamp), CAST(% AS integer))"
 				")"
 				" SELECT \"Vehicle\".*"
 				" FROM \"Ticket\" JOIN \"Vehicle\" ON (\"Vehicle\".\"ID\" = \"Ticket\".\"VehicleCode\"), temp_vals"
@@ -235,6 +241,9 @@ public:
 				" WHERE \"Product\".\"Name\" = %))))"
 				));
 
+			//PATHFINDER
+			well_knowns.emplace_back(std::make_unique<ReachabilityQuery>("Places Reachable From a CoI", pather));
+
 			//QUERIES
 			// Nope.
 		}
@@ -244,7 +253,7 @@ public:
 		setState(DBcontext::MAIN_MENU);
 
 		{	// First query scope (frees locals at the end)
-			query::atomicQuery("SELECT schema_name FROM information_schema.schemata;", res, connection);
+			query::executeQuery("SELECT schema_name FROM information_schema.schemata;", res, connection);
 			query::queryRes extract(res);
 
 #ifdef _DEBUG
@@ -284,7 +293,7 @@ public:
 				auto const& actualName = privates.find(schema) != privates.end() ? schema.substr(17) : schema;
 
 				auto query = query::string_format<char const*>("SELECT table_name FROM information_schema.tables WHERE table_schema = '%s';", actualName.c_str());
-				query::atomicQuery(query.c_str(), res, connection);
+				query::executeQuery(query.c_str(), res, connection);
 				query::queryRes extract(res);
 
 				for (lint i = 0; i < extract.rows; ++i)
@@ -333,11 +342,10 @@ public:
 			currTab.tabSchema = schemaNode.getQueryName();
 			currTab.tabName = root[schemaNode.getName()][std::get<2>(selected_dir)].getName();
 
-			query::atomicQuery(std::string("SELECT COUNT(*) FROM \"" + currTab.tabSchema + "\".\"" + currTab.tabName + "\"").c_str(), res, conn);
+			query::executeQuery(std::string("SELECT COUNT(*) FROM \"" + currTab.tabSchema + "\".\"" + currTab.tabName + "\"").c_str(), res, conn, query::resultFormat::BINARY);
 			query::queryRes extract(res);
 
-			std::stringstream temp(PQgetvalue(extract.result, 0, 0));
-			temp >> currTab.rowCount;
+			currTab.rowCount = static_cast<int>(query::resultView(extract.result).integer(0, 0));
 
 
 			std::cout << currTab.rowCount;
@@ -346,6 +354,7 @@ public:
 		case DBcontext::QUERY_TOOL:
 			printUtil.updateHeader("Query Tool");
 			CLprinter::showCursor(true);
+			startAction("Query Tool");
 			handleQueryTool();
 			break;
 		case DBcontext::MAIN_MENU:
@@ -355,21 +364,25 @@ public:
 		case DBcontext::WK_QUERIES:
 			printUtil.updateHeader("Well-Known Queries and Procedures");
 			CLprinter::showCursor(false);
+			startAction("Well Known Queries");
 			handleWK();
 			break;
 		case DBcontext::PATHFINDER:
 			printUtil.updateHeader("Best-Route Pathfinder");
 			CLprinter::showCursor(true);
+			startAction("Pathfinder");
 			handlePathfinder();
 			break;
 		case DBcontext::ROUTE_CHECKER:
 			printUtil.updateHeader("Client Route Checker");
 			CLprinter::showCursor(true);
+			startAction("Route Checker");
 			handleRouteChecker();
 			break;
 		case DBcontext::SHIPMENT:
 			printUtil.updateHeader("Shipment Scheduler");
 			CLprinter::showCursor(true);
+			startAction("Shipment Scheduler");
 			handleShipments();
 			break;
 		default:
@@ -439,6 +452,31 @@ public:
 			else
 				std::cout << " * " << menu_options[i] << "\n";
 		}
+
+		printActionTraffic();
+	}
+
+	/**
+	 * Starts metering the DB traffic of a UI action, the main menu shows it once the action is over.
+	 */
+	void startAction(const char* name)
+	{
+		actionName = name;
+		actionStart = query::traffic;
+	}
+
+	/**
+	 * Round trips of the last UI action, next to what they were when every statement was wrapped in BEGIN/END.
+	 */
+	void printActionTraffic() const
+	{
+		if (actionName == nullptr)
+			return;
+
+		auto const statements = query::traffic.statements - actionStart.statements;
+		std::cout << "\n " << actionName << ": " << statements << " statements, " << query::traffic.roundTrips - actionStart.roundTrips
+			<< " DB round trips (" << 3 * statements << " with a transaction around every statement), "
+			<< query::traffic.bytesReceived - actionStart.bytesReceived << " bytes received" << std::endl;
 	}
 
 	void handleQueryTool()
@@ -496,7 +534,7 @@ public:
 
 			std::cout << "\n\n";
 
-			if(query::atomicQuery(query.c_str(), res, conn))
+			if(query::executeQuery(query.c_str(), res, conn))
 				printUtil.printTable(res);
 
 			query.clear();
@@ -538,7 +576,7 @@ public:
 				break;
 			case ENTER_KEY:
 				std::cout << "\n";
-				well_knowns[selected_wk]->execute(res, conn);
+				well_knowns[selected_wk]->execute(res, prepared);
 				_getch();
 				PQclear(res);
 				break;
@@ -561,6 +599,193 @@ public:
 		refreshScreen();
 	}
 
+	void handleBatchPathfinder()
+	{
+		std::string file;
+		std::string input;
+		std::vector<paths::routeRequest> requests;
+
+		std::cout << "\n Path of the batch file, one \"from CoI,to CoI,client[,special option[,allowed vehicles]]\" line per route: ";
+		std::cin >> file;
+
+		if (!Pathfinder::readBatch(file, requests))
+		{
+			_getch();
+			return;
+		}
+
+		std::cout << "\n " << requests.size() << " routes read, do you wish to inject every route found (y)?" << std::endl;
+		std::cin >> input;
+
+		std::cout << "\n Pathing...\n" << std::endl;
+		auto results = pather.pathfindBatch(requests, input == "y");
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			std::cout << " (" << i << "): " << requests[i].from << " -> " << requests[i].to << ": ";
+			if (results[i].found)
+				std::cout << results[i].path.size() << " legs, distance " << (results[i].path.empty() ? 0.0 : results[i].path.back().distance) << std::endl;
+			else
+				std::cout << color::FIELD << "no route" << color::RESET << std::endl;
+		}
+
+		printCacheStats();
+		_getch();
+	}
+
+	void handleReplanRoutes()
+	{
+		std::cout << "\n Replanning the routes hit by connection changes...\n" << std::endl;
+		auto repairs = pather.replanRoutes();
+
+		for (auto const& repair : repairs)
+		{
+			std::cout << " Route " << color::FIELD << repair.route << color::RESET;
+			if (!repair.shipments.empty())
+			{
+				std::cout << " (shipments";
+				for (auto const shipment : repair.shipments)
+					std::cout << " " << shipment;
+				std::cout << ")";
+			}
+
+			// A route stays broken until it is injected again, it was already before then
+			auto cost = [](double value) {
+				if (value == paths::IncrementalSearch::INF)
+					std::cout << color::FIELD << "broken" << color::RESET;
+				else
+					std::cout << value;
+			};
+
+			std::cout << ": was ";
+			cost(repair.previousCost);
+			std::cout << ", now ";
+			cost(repair.currentCost);
+
+			if (!repair.repaired.found)
+			{
+				std::cout << ", " << color::FIELD << "no route left" << color::RESET << std::endl;
+				continue;
+			}
+
+			std::cout << ", repaired " << repair.repaired.cost << " (";
+			if (repair.previousCost != paths::IncrementalSearch::INF)
+			{
+				double const delta = repair.repaired.cost - repair.previousCost;
+				std::cout << (delta >= 0.0 ? "+" : "") << delta << ", ";
+			}
+			std::cout << repair.repaired.expanded << " places expanded)\n  ";
+
+			for (auto const& leg : repair.repaired.path)
+				std::cout << leg.from << " -> ";
+			std::cout << (repair.repaired.path.empty() ? int64_t(0) : repair.repaired.path.back().to) << std::endl;
+		}
+
+		std::cout << "\n " << repairs.size() << " routes affected." << std::endl;
+		_getch();
+	}
+
+	void handleDistanceMatrix()
+	{
+		std::string company;
+		std::string vehicles;
+		std::string file;
+		paths::pathOptions options;
+		paths::DistanceMatrix matrix;
+
+		std::cout << "\n Company code (0 for every Center of Interest): ";
+		std::cin >> company;
+
+		std::cout << "\n Allowed vehicles, sum of:\n    1: Plane\n    2: Ship\n    4: Car\n    default: all of them" << std::endl;
+		std::cin >> vehicles;
+
+		if (vehicles != "default") {
+			options.allowedVehicles = (char) (_strtoi64(vehicles.c_str(), nullptr, 10) & paths::ALL_VEHICLES);
+		}
+
+		std::cout << "\n Computing...\n" << std::endl;
+		auto start = std::chrono::steady_clock::now();
+
+		if (!pather.distanceMatrix(_strtoi64(company.c_str(), nullptr, 10), options, matrix))
+		{
+			_getch();
+			return;
+		}
+
+		auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << " " << matrix.size() << " x " << matrix.size() << " Centers of Interest in " << elapsed << " ms ("
+			<< matrix.getSettled() << " places settled, " << matrix.memoryBytes() / 1024 << " KiB)" << std::endl;
+
+		// Small matrices are shown right away, the others are only worth a file
+		if (matrix.size() <= 8)
+		{
+			std::cout << "\n from \\ to";
+			for (size_t j = 0; j < matrix.size(); ++j)
+				std::cout << "\t" << matrix.centerAt(j);
+			std::cout << std::endl;
+
+			for (size_t i = 0; i < matrix.size(); ++i)
+			{
+				std::cout << " " << matrix.centerAt(i);
+				for (size_t j = 0; j < matrix.size(); ++j)
+				{
+					if (matrix.distance(i, j) == paths::DistanceMatrix::UNREACHABLE)
+						std::cout << "\t-";
+					else
+						std::cout << "\t" << matrix.distance(i, j) << " (" << matrix.fee(i, j) << ")";
+				}
+				std::cout << std::endl;
+			}
+		}
+
+		std::cout << "\n File to save the matrix to (ending in .csv for a text listing, \"no\" to skip): ";
+		std::cin >> file;
+
+		if (file != "no")
+		{
+			bool const csv = file.size() >= 4 && file.compare(file.size() - 4, 4, ".csv") == 0;
+			if (csv ? matrix.writeCsv(file) : matrix.save(file))
+				std::cout << " Saved to " << file << "." << std::endl;
+		}
+
+		_getch();
+	}
+
+	void printCacheStats() const
+	{
+		auto const& cache = pather.getCache();
+		std::cout << "\n Route cache: " << cache.getHits() << " hits, " << cache.getMisses() << " misses, "
+			<< cache.size() << " routes (" << cache.memoryBytes() / 1024 << " KiB)" << std::endl;
+		std::cout << " Connection graph: " << pather.getFullLoads() << " full loads, " << pather.getSnapshotLoads() << " snapshot loads, "
+			<< pather.getChangesApplied() << " changes applied live" << std::endl;
+	}
+
+	/**
+	 * Shows what the last route request cost, then the same figures as one machine-readable line.
+	 */
+	void printSearchStats() const
+	{
+		auto const& stats = pather.getLastStats();
+
+		std::cout << "\n Search statistics (" << paths::modeName(stats.mode) << (stats.cached ? ", served from the cache" : "") << "):" << std::endl;
+		std::cout << "    " << stats.expanded << " places expanded";
+		if (stats.frontierCounted)
+		{
+			std::cout << ", " << stats.pushes << " pushes (" << stats.duplicatePushes << " duplicates), " << stats.pops << " pops, "
+				<< stats.relaxed << " connections relaxed";
+		}
+		std::cout << std::endl;
+
+		std::cout << "    " << stats.roundTrips << " DB round trips, " << stats.bytesReceived << " bytes received" << std::endl;
+
+		std::cout << "    ";
+		for (size_t phase = 0; phase < paths::searchStats::PHASES; ++phase)
+			std::cout << paths::phaseName(static_cast<paths::SearchPhase>(phase)) << " " << stats.phaseMs[phase] << " ms, ";
+		std::cout << "total " << stats.totalMs() << " ms" << std::endl;
+
+		std::cout << " " << stats.toRecord() << std::endl;
+	}
+
 	void handlePathfinder()
 	{
 
@@ -573,18 +798,34 @@ public:
 			std::system("CLS");
 			printUtil.printHeader();
 
-			std::cout << "\n Welcome!\n Please insert your client code: ";
+			std::cout << "\n Welcome!\n Please insert your client code (or \"batch\" to plan routes listed in a file, \"replan\" to repair routes hit by connection changes,\n \"matrix\" for the distances between Centers of Interest): ";
 			std::cin >> code;
 
 			if (code == "exit") break;
 
+			if (code == "batch")
+			{
+				handleBatchPathfinder();
+				continue;
+			}
+
+			if (code == "replan")
+			{
+				handleReplanRoutes();
+				continue;
+			}
+
+			if (code == "matrix")
+			{
+				handleDistanceMatrix();
+				continue;
+			}
+
 			std::system("CLS");
 			printUtil.printHeader();
 			outBuf.str(std::string());
 
-			outBuf << "SELECT co.\"Name\" FROM public.\"Company\" as co, public.\"Client\" as cl WHERE co.\"ID\" = " << code << "  AND cl.\"CompanyCode\" =" << code;
-
-			if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+			if (prepared.execute(query::statements::CLIENT_COMPANY_NAME, { code }, res) && PQntuples(res) > 0)
 			{
 				std::cout << "\n Welcome " << color::FIELD << PQgetvalue(res, 0, 0) << color::RESET << std::endl;
 				PQclear(res);
@@ -598,9 +839,7 @@ public:
 				continue;
 			}
 
-			outBuf << "SELECT coi.\"Name\", coi.\"ID\", coi.\"Type\" FROM public.\"CenterOfInterest\" as coi WHERE coi.\"CompanyCode\" = " << code;
-
-			if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+			if (prepared.execute(query::statements::COMPANY_CENTERS, { code }, res) && PQntuples(res) > 0)
 			{
 				std::cout << "\n\n A list of your currently registered Centers of Interest to aid you in choosing the endpoints: " << std::endl;
 				printUtil.printTable(res);
@@ -621,7 +860,7 @@ public:
 			std::cin >> coi_two;
 
 			std::string selection;
-			std::cout << "\n Special options:\n    default/0: No special options\n    1: Prefer cars\n    2: Discourage Planes\n    3: Discourage Ships\n    4: Less costly"<< std::endl;
+			std::cout << "\n Special options:\n    default/0: No special options\n    1: Prefer cars\n    2: Discourage Planes\n    3: Discourage Ships\n    4: Less costly\n    5: Balanced distance and fee"<< std::endl;
 			std::cin >> selection;
 
 			int64_t actual_selection = 0;
@@ -629,8 +868,52 @@ public:
 				actual_selection = _strtoi64(selection.c_str(), nullptr, 10);
 			}
 
+			std::string mode;
+			std::cout << "\n Search mode:\n    default/0: Unidirectional A*\n    1: Bidirectional A*\n    2: Compare all modes (benchmark, nothing is injected)\n    3: Contraction Hierarchy (shortest distance, ignores special options)\n    4: Every trade-off between distance, fee and vehicle changes (ignores special options)\n    5: Anytime A* (a route at once, improved until it is the best one)\n    6: Alternative routes (the cheapest ones, pick one)" << std::endl;
+			std::cin >> mode;
+
+			paths::pathOptions options;
+			if (mode != "2")
+			{
+				std::string vehicles;
+				std::cout << "\n Allowed vehicles, sum of:\n    1: Plane\n    2: Ship\n    4: Car\n    default: all of them" << std::endl;
+				std::cin >> vehicles;
+
+				if (vehicles != "default") {
+					options.allowedVehicles = (char) (_strtoi64(vehicles.c_str(), nullptr, 10) & paths::ALL_VEHICLES);
+				}
+			}
+
+			if (mode == "6")
+			{
+				std::string count;
+				std::cout << "\n How many routes (default: " << options.alternatives << ")?" << std::endl;
+				std::cin >> count;
+
+				if (count != "default") {
+					options.alternatives = (unsigned) std::max<int64_t>(1, _strtoi64(count.c_str(), nullptr, 10));
+				}
+			}
+
 			std::cout << "\n Pathing...\n" << std::endl;
-			pather.pathfind(_strtoi64(coi_one.c_str(), nullptr, 10), _strtoi64(coi_two.c_str(), nullptr, 10), _strtoi64(code.c_str(), nullptr, 10), (short) actual_selection);
+			if (mode == "2")
+			{
+				pather.benchmark(_strtoi64(coi_one.c_str(), nullptr, 10), _strtoi64(coi_two.c_str(), nullptr, 10), (short) actual_selection);
+			}
+			else
+			{
+				auto search_mode = paths::SearchMode::UNIDIRECTIONAL;
+				if (mode == "1") search_mode = paths::SearchMode::BIDIRECTIONAL;
+				else if (mode == "3") search_mode = paths::SearchMode::CONTRACTION_HIERARCHY;
+				else if (mode == "4") search_mode = paths::SearchMode::PARETO;
+				else if (mode == "5") search_mode = paths::SearchMode::ANYTIME;
+				else if (mode == "6") search_mode = paths::SearchMode::ALTERNATIVES;
+
+				pather.pathfind(_strtoi64(coi_one.c_str(), nullptr, 10), _strtoi64(coi_two.c_str(), nullptr, 10), _strtoi64(code.c_str(), nullptr, 10), (short) actual_selection, search_mode, options);
+				printSearchStats();
+			}
+
+			printCacheStats();
 			
 			auto c = parseKey(_getch());
 
@@ -661,9 +944,7 @@ public:
 			printUtil.printHeader();
 			outBuf.str(std::string());
 
-			outBuf << "SELECT co.\"Name\" FROM public.\"Company\" as co, public.\"Client\" as cl WHERE co.\"ID\" = " << code << "  AND cl.\"CompanyCode\" =" << code;
-
-			if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+			if (prepared.execute(query::statements::CLIENT_COMPANY_NAME, { code }, res) && PQntuples(res) > 0)
 			{
 				std::cout << "\n Welcome " << color::FIELD << PQgetvalue(res, 0, 0) << color::RESET << std::endl;
 				PQclear(res);
@@ -677,18 +958,12 @@ public:
 				continue;
 			}
 
-			outBuf << "SELECT ro.* FROM \"Route\" as ro JOIN \"ViewPrivilege\" as view ON (ro.\"ID\" = view.\"RouteCode\")" <<
-					  "WHERE view.\"CompCode\" = " << code;
-
 			std::unordered_set<int64_t> route_codes;
 
-			if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+			if (prepared.execute(query::statements::COMPANY_ROUTES, { code }, res) && PQntuples(res) > 0)
 			{
-				size_t nRows = PQntuples(res);
-
-				for (size_t route_i = 0; route_i < nRows; route_i++) {
-					route_codes.insert(_strtoi64(PQgetvalue(res, (int) route_i, 0), nullptr, 10));
-				}
+				for (int64_t const route_code : query::resultView(res).get<int64_t>(0))
+					route_codes.insert(route_code);
 
 				std::cout << "\n Here are your routes " << std::endl;
 				printUtil.printTable(res);
@@ -731,12 +1006,11 @@ public:
 
 				outBuf.str(std::string());
 
-				outBuf << "SELECT * FROM public.\"Contains\" WHERE \"Contains\".\"RouteCode\" = " << route_id << "ORDER BY \"Contains\".\"Order\"";
-
-				if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+				if (prepared.execute(query::statements::ROUTE_CONTAINS, { std::to_string(route_id) }, res) && PQntuples(res) > 0)
 				{
 					std::cout << "\n A summary of the route (in terms of places):" << std::endl;
 					printUtil.printTable(res);
+					PQclear(res);
 					outBuf.str(std::string());
 				}
 				else
@@ -780,9 +1054,7 @@ public:
 
 			outBuf.str(std::string());
 
-			outBuf << "SELECT co.\"Name\" FROM public.\"Company\" as co, public.\"Client\" as cl WHERE co.\"ID\" = " << comp_code << "  AND cl.\"CompanyCode\" =" << comp_code;
-
-			if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+			if (prepared.execute(query::statements::CLIENT_COMPANY_NAME, { comp_code }, res) && PQntuples(res) > 0)
 			{
 				std::cout << "\n Welcome " << color::FIELD << PQgetvalue(res, 0, 0) << color::RESET << std::endl;
 				PQclear(res);
@@ -798,9 +1070,7 @@ public:
 
 			outBuf.str(std::string());
 
-			outBuf << "SELECT coi.\"Name\", coi.\"ID\", coi.\"Type\" FROM public.\"CenterOfInterest\" as coi WHERE coi.\"CompanyCode\" = " << comp_code;
-
-			if (!(query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0))
+			if (!(prepared.execute(query::statements::COMPANY_CENTERS, { comp_code }, res) && PQntuples(res) > 0))
 			{
 				std::cout << "\n Alas, your company has no Centers of Interest in our system" << std::endl;
 				_getch();
@@ -818,10 +1088,16 @@ public:
 
 			std::cin >> coi;
 
-			outBuf << "SELECT ro.\"ID\", ro.\"ToCode\" FROM public.\"Route\" as ro JOIN public.\"ViewPrivilege\" as vi ON (ro.\"ID\" = vi.\"RouteCode\") WHERE ro.\"FromCode\" =" << coi << " AND vi.\"CompCode\" =" << comp_code;
+			// The routes and the stock of the Center only need its code, fetch both at once
+			query::pipeline centerLookups(conn, prepared);
+			size_t const routesLookup = centerLookups.add(query::statements::ROUTES_FROM_CENTER, { coi, comp_code });
+			size_t const stockLookup = centerLookups.add(query::statements::CENTER_STOCK, { coi });
+			centerLookups.run();
 
-			if (!(query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0))
+			res = centerLookups.take(routesLookup);
+			if (!(res && PQntuples(res) > 0))
 			{
+				PQclear(res);
 				std::cout << "\n We're sorry, that Center of Interest has no routes originating from it" << std::endl;
 				_getch();
 				outBuf.str(std::string());
@@ -838,28 +1114,24 @@ public:
 
 			std::cout << "\n Your selected Center of Interest has this stock: ";
 
-			outBuf << "SELECT \"Product\".\"Name\", \"Product\".\"ID\", \"Stock\".\"Qty\"" <<
-				" FROM \"Stock\" JOIN \"Product\" ON(\"Stock\".\"ProdCode\" = \"Product\".\"ID\")" <<
-				" WHERE \"Stock\".\"CoICode\" = " << coi;
-
 			std::map<int64_t, int64_t> productQuantities;
 
-			if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+			res = centerLookups.take(stockLookup);
+			if (res && PQntuples(res) > 0)
 			{
-				size_t nRows = PQntuples(res);
+				query::resultView stock(res);
+				auto const prod_ids = stock.get<int64_t>(1);
+				auto const prod_qtys = stock.get<int64_t>(2);
 
-				for (size_t i_prod = 0; i_prod < nRows; i_prod++) {
-
-					int64_t prod_id = _strtoi64(PQgetvalue(res, i_prod, 1), nullptr, 10);
-					int64_t prod_qty = _strtoi64(PQgetvalue(res, i_prod, 2), nullptr, 10);
-					productQuantities.insert_or_assign(prod_id, prod_qty);
-				}
+				for (int i_prod = 0; i_prod < stock.rows(); i_prod++)
+					productQuantities.insert_or_assign(prod_ids[i_prod], prod_qtys[i_prod]);
 
 				printUtil.printTable(res);
 				PQclear(res);
 				outBuf.str(std::string());
 			} else {
 				std::cout << "\n We're sorry, that Center of Interest's stocks are empty" << std::endl;
+				PQclear(res);
 				_getch();
 				outBuf.str(std::string());
 				continue;
@@ -942,27 +1214,20 @@ public:
 
 			bool priority_comp = (input_res == "y");
 
-			outBuf << "SELECT ct.\"PlaceACode\" as \"Place A\", ct.\"PlaceBCode\" as \"Place B\", ct.\"AllowedVehicle\"" <<
-				" FROM \"Contains\" as ct" <<
-				" WHERE ct.\"RouteCode\" = " << route <<
-				" ORDER BY ct.\"Order\" ASC";
-
 			// yes. i don't care. fight me.
 			using passage = std::tuple<int64_t, int64_t, paths::VehicleType>;
 			std::vector<passage> contain;
 
-			if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+			if (prepared.execute(query::statements::ROUTE_LEGS, { route }, res) && PQntuples(res) > 0)
 			{
-				size_t nRows = PQntuples(res);
+				query::resultView legs(res);
+				auto const places_a = legs.get<int64_t>(0);
+				auto const places_b = legs.get<int64_t>(1);
+				auto const vehicles = legs.get<std::string_view>(2);
 
-				for (size_t i = 0; i < nRows; i++) {
-	
-					auto vCode = std::string(PQgetvalue(res, i, 2));
-					paths::VehicleType vType = (vCode == "Car") ? paths::CAR : ((vCode == "Plane") ? paths::PLANE : paths::SHIP);
-
-					// PlaceA, PlaceB and Vehicle
-					contain.emplace_back(_strtoi64(PQgetvalue(res, i, 0), nullptr, 10), _strtoi64(PQgetvalue(res, i, 1), nullptr, 10), vType);
-				}
+				// PlaceA, PlaceB and Vehicle
+				for (int i = 0; i < legs.rows(); i++)
+					contain.emplace_back(places_a[i], places_b[i], paths::toVehicle(vehicles[i]));
 
 				std::cout << "\n This is the route you have chosen: " << std::endl;
 
@@ -977,8 +1242,25 @@ public:
 				continue;
 			}
 
+			// Free vehicles at the start of every leg, all in one round trip. The neighbours are only asked
+			// for when a leg has none, their lookup leaves out the vehicle chosen for the previous leg
+			query::pipeline legLookups(conn, prepared);
+			std::vector<size_t> ownLookups;
+			std::vector<size_t> freeLookups;
+
+			for (auto const& [placeA, placeB, vType] : contain) {
+				std::string const str_vType = (vType == paths::CAR) ? "Car" : ((vType == paths::PLANE) ? "Plane" : "Ship");
+
+				if (priority_comp)
+					ownLookups.push_back(legLookups.add(query::statements::FREE_OWN_VEHICLES, { std::to_string(placeA), str_vType, comp_code }));
+				freeLookups.push_back(legLookups.add(query::statements::FREE_VEHICLES, { std::to_string(placeA), str_vType }));
+			}
+
+			legLookups.run();
+
 			paths::VehicleType prev_type = paths::CAR;
 			int64_t prev_id = -1;
+			size_t leg = 0;
 
 			std::vector<int64_t> chosen_ids;
 
@@ -992,13 +1274,13 @@ public:
 
 				switch (vType) {
 					case paths::CAR:
-						str_vType = "\'Car\'";
+						str_vType = "Car";
 						break;
 					case paths::SHIP:
-						str_vType = "\'Ship\'";
+						str_vType = "Ship";
 						break;
 					case paths::PLANE:
-						str_vType = "\'Plane\'";
+						str_vType = "Plane";
 						break;
 					default:
 						std::cout << "What...";
@@ -1010,19 +1292,11 @@ public:
 				if (!priority_comp) {
 					goto NO_PREF;
 				}
-				outBuf << "SELECT *"
-					" FROM \"NotCurrentlyUsed\" as nsd"
-					" WHERE nsd.\"Depot\" =" << placeA <<
-					" AND nsd.\"Type\" =" << str_vType <<
-					" AND nsd.\"Owner\" = " << comp_code;
-
-				if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+				res = legLookups.take(ownLookups[leg]);
+				if (res && PQntuples(res) > 0)
 				{
-					size_t nRows = PQntuples(res);
-
-					for (size_t i = 0; i < nRows; i++) {
-						available_ids.insert(_strtoi64(PQgetvalue(res, i, 1), nullptr, 10));
-					}
+					for (int64_t const vehicle_id : query::resultView(res).get<int64_t>(1))
+						available_ids.insert(vehicle_id);
 
 					std::cout << "\n These are the available vehicles from your company: " << std::endl;
 
@@ -1035,17 +1309,11 @@ public:
 					NO_PREF:
 					outBuf.str(std::string());
 
-					outBuf << "SELECT *"
-						" FROM \"NotCurrentlyUsed\" as nsd"
-						" WHERE nsd.\"Depot\" =" << placeA <<
-						" AND nsd.\"Type\" =" << str_vType;
-					if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+					res = legLookups.take(freeLookups[leg]);
+					if (res && PQntuples(res) > 0)
 					{
-						size_t nRows = PQntuples(res);
-
-						for (size_t i = 0; i < nRows; i++) {
-							available_ids.insert(_strtoi64(PQgetvalue(res, i, 1), nullptr, 10));
-						}
+						for (int64_t const vehicle_id : query::resultView(res).get<int64_t>(1))
+							available_ids.insert(vehicle_id);
 
 						std::cout << "\n These are the available vehicles: " << std::endl;
 
@@ -1057,17 +1325,10 @@ public:
 						std::cout << "\n Couldn't find any available vehicle at " << placeA << ", checking neighbors..." << std::endl;
 						PQclear(res);
 						outBuf.str(std::string());
-						outBuf << "SELECT nsd.*"
-							"FROM \"NotCurrentlyUsed\" as nsd JOIN \"Connection\" as cn ON (nsd.\"Depot\" = cn.\"PlaceA\" AND nsd.\"Type\" = cn.\"AllowedVehicles\")"
-							"WHERE cn.\"PlaceB\" = " << placeA << " AND cn.\"AllowedVehicles\" = " << str_vType <<
-							"AND nsd.\"ID\" <>" << prev_id;
-						if (query::atomicQuery(outBuf.str().c_str(), res, conn) && PQntuples(res) > 0)
+						if (prepared.execute(query::statements::FREE_NEIGHBOUR_VEHICLES, { std::to_string(placeA), str_vType, std::to_string(prev_id) }, res) && PQntuples(res) > 0)
 						{
-							size_t nRows = PQntuples(res);
-
-							for (size_t i = 0; i < nRows; i++) {
-								available_ids.insert(_strtoi64(PQgetvalue(res, i, 1), nullptr, 10));
-							}
+							for (int64_t const vehicle_id : query::resultView(res).get<int64_t>(1))
+								available_ids.insert(vehicle_id);
 
 							std::cout << "\n These are the available vehicles from your adjacent neighbours: " << std::endl;
 
@@ -1135,6 +1396,7 @@ public:
 				}
 				USE_CURRENT:
 				chosen_ids.push_back(prev_id);
+				++leg;
 			}
 
 			outBuf.str(std::string());
@@ -1195,7 +1457,7 @@ public:
 
 			outBuf << qtys_str << ", " << prod_str << ", " << comp_code << ", " << veh_str << ")";
 
-			if (!query::atomicQuery(outBuf.str().c_str(), res, conn))
+			if (!query::executeQuery(outBuf.str().c_str(), res, conn))
 			{
 				std::cerr << "There has been a problem in finalizing your shipment, check the stack strace for more detail. " << std::endl;
 				_getch();
@@ -1385,7 +1647,7 @@ public:
 				if (currTab.selected_opt == 0)
 				{
 					refreshScreen();
-					query::atomicQuery(std::string("SELECT * FROM \"" + currTab.tabSchema + "\".\"" + currTab.tabName + "\"").c_str(), res, conn);
+					query::executeQuery(std::string("SELECT * FROM \"" + currTab.tabSchema + "\".\"" + currTab.tabName + "\"").c_str(), res, conn);
 					printUtil.printTable(res);
 					PQclear(res);
 				}
@@ -1469,6 +1731,7 @@ private:
 	Dbnode<NODE::ROOT> root;
 	PGresult* res;
 	PGconn* conn;
+	query::preparedStatements prepared;
 	CLprinter printUtil;
 	std::ostringstream outBuf;
 	std::tuple<int64_t, int64_t, int64_t> selected_dir;
@@ -1484,4 +1747,7 @@ private:
 	std::array<std::string, 6> menu_options;
 	int64_t selected_menu_opt;
 	Pathfinder pather;
+
+	const char* actionName = nullptr;	// UI action metered since actionStart, see startAction()
+	query::wireCounters actionStart;
 };
\ No newline at end of file
@@ -2,246 +2,1683 @@
 #include <functional>
 #include "..\DButils\CLprinter.h"
 #include "..\DButils\queries.h"
+#include "..\DButils\ResultView.h"
 #include <queue>
 #include <sstream>
 #include <vector>
 #include <map>
-#include <unordered_set>
-#include <stack>
+#include <set>
 #include <algorithm>
+#include <limits>
+#include <chrono>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <unordered_map>
+#include <type_traits>
+#include <conio.h>
 
 
-namespace paths
+namespace
 {
-	using pathtup = std::tuple<double, paths::VehicleType, double>;
+	// Milliseconds gone by since from
+	double msSince(std::chrono::steady_clock::time_point from)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+	}
+}
+
+bool Pathfinder::resolvePlace(int64_t coi_code, int64_t& place_code, const char* which)
+{
+	PGresult* res = nullptr;
+
+	if (!(prepared.execute(query::statements::CENTER_PLACE, { std::to_string(coi_code) }, res) && PQntuples(res) > 0))
+	{
+		std::cerr << "The " << which << " Center of Interest does not exist, aborting!" << std::endl;
+		PQclear(res);
+		return false;
+	}
+
+	place_code = query::resultView(res).integer(0, 0);
+	PQclear(res);
+	return true;
+}
+
+bool Pathfinder::prepare(int64_t from_code, int64_t to_code, uint32_t& source, uint32_t& goal, paths::searchStats* stats)
+{
+	/*
+	
+	Initializing CoI codes to Place Codes
+	
+	*/
+	int64_t placecode_from = 0;
+	int64_t placecode_to = 0;
+
+	auto phase = std::chrono::steady_clock::now();
+	bool const resolved = resolvePlace(from_code, placecode_from, "first") && resolvePlace(to_code, placecode_to, "second");
+
+	if (stats)
+		stats->time(paths::SearchPhase::LOOKUP) += msSince(phase);
+
+	if (!resolved)
+		return false;
+
+	phase = std::chrono::steady_clock::now();
+	bool const loaded = loadGraph();
+
+	if (stats)
+		stats->time(paths::SearchPhase::GRAPH) += msSince(phase);
+
+	if (!loaded)
+		return false;
+
+	source = graph.indexOf(placecode_from);
+	goal = graph.indexOf(placecode_to);
+
+	if (source == paths::GraphSnapshot::NO_NODE)
+	{
+		std::cerr << "The first Center of Interest lies on an unknown place, aborting!" << std::endl;
+		return false;
+	}
+
+	if (goal == paths::GraphSnapshot::NO_NODE)
+	{
+		std::cerr << "The second Center of Interest lies on an unknown place, aborting!" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Pathfinder::readGraphVersion(int64_t& version)
+{
+	if (!versioned)
+		return false;
+
+	if (!paths::readConnectionVersion(conn, version))
+	{
+		std::cerr << "The \"ConnectionVersion\" sequence is missing, the route cache stays off and the graph is never reloaded." << std::endl;
+		versioned = false;
+		return false;
+	}
+
+	return true;
+}
+
+bool Pathfinder::loadGraph()
+{
+	int64_t version = 0;
+
+	// Subscribe before the first load: a change committed later is either part of the load or delivered afterwards
+	if (versioned && !listener.isListening())
+		listener.listen(conn);
+
+	// Changes committed up to the version read have all been delivered by the time the query is over
+	bool const known = readGraphVersion(version);
+
+	if (graph.isLoaded() && listener.isListening() && !applyDeltas())
+		invalidateGraph();
+
+	// A version no change was received for (a TRUNCATE, a transaction still open or rolled back) needs a full load
+	if (known && graph.isLoaded() && version > graphVersion)
+		invalidateGraph();
+
+	if (!graph.isLoaded())
+	{
+		// Whatever was delivered so far is already part of what is about to be loaded
+		std::vector<paths::edgeDelta> delivered;
+		if (listener.isListening())
+			listener.poll(conn, delivered);
+
+		// Without a version there is no telling whether the file is current, so it is only used alongside one
+		int64_t stored = 0;
+		if (known && !snapshotPath.empty() && graph.map(snapshotPath, stored) && stored == version)
+		{
+			// A file written without landmarks still works, they are only kept in memory then
+			if (graph.getLandmarks().size() == 0)
+				graph.placeLandmarks(paths::LandmarkTable::DEFAULT_COUNT);
+
+			graphVersion = version;
+			snapshotStale = false;
+			++snapshotLoads;
+			return true;
+		}
+
+		if (!graph.load(conn))
+		{
+			std::cerr << "The pathfinder could not load the connection graph, aborting!" << std::endl;
+			return false;
+		}
+		graphVersion = version;
+		++fullLoads;
+
+		graph.placeLandmarks(paths::LandmarkTable::DEFAULT_COUNT);
+
+		snapshotStale = known && !snapshotPath.empty() && !graph.save(snapshotPath, graphVersion);
+	}
+
+	// Inserted connections that shorten a landmark distance drop the tables, they go with the graph
+	if (graph.getLandmarks().size() == 0 && graph.nodeCount() > 0)
+		graph.placeLandmarks(paths::LandmarkTable::DEFAULT_COUNT);
+
+	return true;
+}
+
+Pathfinder::~Pathfinder()
+{
+	if (snapshotStale && graph.isLoaded() && !graph.save(snapshotPath, graphVersion))
+		std::cerr << "Could not update the graph snapshot, the next start will load the graph from the DB." << std::endl;
+}
+
+bool Pathfinder::applyDeltas()
+{
+	std::vector<paths::edgeDelta> deltas;
+
+	if (!listener.poll(conn, deltas))
+		return false;
+
+	if (deltas.empty())
+		return true;
+
+	// What the changed connections were before, for the routes replanRoutes() reports
+	for (auto const& delta : deltas)
+	{
+		uint32_t const from = graph.indexOf(delta.from);
+		uint32_t const to = graph.indexOf(delta.to);
+		if (from == paths::GraphSnapshot::NO_NODE || to == paths::GraphSnapshot::NO_NODE)
+			continue;
+
+		uint32_t const edge = graph.findEdge(from, to, delta.vehicle);
+		changedConnections.emplace(std::make_tuple(from, to, delta.vehicle),
+			edge == paths::GraphSnapshot::NO_EDGE ? paths::IncrementalSearch::INF : graph.distance(edge));
+	}
+
+	if (!graph.apply(deltas))
+		return false;
+
+	// The layers, the hierarchies and the cached routes cannot be patched, they are rebuilt on demand
+	dropDerived();
+	cache.clear();
+
+	for (auto const& delta : deltas)
+		graphVersion = std::max(graphVersion, delta.version);
+
+	changesApplied += deltas.size();
+	snapshotStale = versioned && !snapshotPath.empty();
+	return true;
+}
+
+paths::routeKey Pathfinder::keyOf(uint32_t source, uint32_t goal, short special_case, paths::SearchMode mode, char allowed_vehicles) const
+{
+	// The hierarchy ignores special options, they must not split its cache; every mode honours the vehicles
+	bool const hierarchy = (mode == paths::SearchMode::CONTRACTION_HIERARCHY);
+
+	return { graph.placeOf(source), graph.placeOf(goal), graphVersion, hierarchy ? short(0) : special_case, mode,
+		char(allowed_vehicles & paths::ALL_VEHICLES) };
+}
+
+void Pathfinder::pathfind(int64_t from_code, int64_t to_code, int64_t client, short special_case, paths::SearchMode mode, paths::pathOptions const& options)
+{
+	lastStats = paths::searchStats();
+	lastStats.mode = mode;
+
+	auto const before = query::traffic;
+	findRoute(from_code, to_code, client, special_case, mode, options);
+
+	lastStats.roundTrips = query::traffic.roundTrips - before.roundTrips;
+	lastStats.bytesReceived = query::traffic.bytesReceived - before.bytesReceived;
+}
+
+void Pathfinder::countFrontier(paths::SearchContext const& ctx)
+{
+	auto const& ops = ctx.getCounters();
+	lastStats.pushes += ops.pushes + ops.decreases;
+	lastStats.duplicatePushes += ops.decreases;
+	lastStats.pops += ops.pops;
+	lastStats.relaxed += ctx.getRelaxations();
+	lastStats.frontierCounted = true;
+}
+
+void Pathfinder::findRoute(int64_t from_code, int64_t to_code, int64_t client, short special_case, paths::SearchMode mode, paths::pathOptions const& options)
+{
+	uint32_t source = 0;
+	uint32_t goal = 0;
+
+	if (!prepare(from_code, to_code, source, goal, &lastStats))
+		return;
+
+	auto const searching = std::chrono::steady_clock::now();
+
+	if (mode == paths::SearchMode::PARETO)
+	{
+		size_t expanded = 0;
+		auto front = searchPareto(source, goal, layerFor(options.allowedVehicles), expanded);
+		lastStats.time(paths::SearchPhase::SEARCH) = msSince(searching);
+		lastStats.expanded = expanded;
+
+		if (front.empty())
+		{
+			std::cerr << "No route connects the two Centers of Interest!" << std::endl;
+			return;
+		}
+
+		size_t chosen = chooseRoute(front);
+		if (chosen < front.size())
+			offerPath(front[chosen].path, from_code, to_code, client);
+		return;
+	}
+
+	if (mode == paths::SearchMode::ALTERNATIVES)
+	{
+		auto routes = searchAlternatives(source, goal, options.alternatives, special_case, layerFor(options.allowedVehicles), forwardSpace, backwardSpace);
+		lastStats.time(paths::SearchPhase::SEARCH) = msSince(searching);
+		lastStats.expanded = routes.empty() ? 0 : routes.back().expanded;
+
+		if (routes.empty())
+		{
+			std::cerr << "No route connects the two Centers of Interest!" << std::endl;
+			return;
+		}
+
+		size_t chosen = chooseAlternative(routes);
+		if (chosen < routes.size())
+			offerPath(routes[chosen].path, from_code, to_code, client);
+		return;
+	}
+
+	if (mode == paths::SearchMode::ANYTIME)
+	{
+		using clock = std::chrono::steady_clock;
+		auto const start = clock::now();
+
+		std::cout << " Routes get better until the best one is found, press any key to settle for the last one." << std::endl;
+
+		auto best = searchAnytime(source, goal, special_case, layerFor(options.allowedVehicles), forwardSpace,
+			[&](paths::searchResult const& route, double suboptimality) {
+				std::cout << " " << std::chrono::duration<double, std::milli>(clock::now() - start).count() << " ms: ";
+				if (suboptimality <= 1.0)
+					std::cout << "best route";
+				else
+					std::cout << "at most " << suboptimality << " times the best cost";
+				std::cout << ", cost " << route.cost << ", " << route.path.size() << " legs, distance "
+					<< (route.path.empty() ? 0.0 : route.path.back().distance) << ", " << route.expanded << " places expanded so far" << std::endl;
+
+				std::cout << "   ";
+				for (auto const& leg : route.path)
+					std::cout << leg.from << " -> ";
+				std::cout << graph.placeOf(goal) << std::endl;
+
+				return !_kbhit();
+			});
+
+		lastStats.time(paths::SearchPhase::SEARCH) = msSince(searching);
+		lastStats.expanded = best.expanded;
+		countFrontier(forwardSpace);
+
+		// The key that stopped the refinement is not an answer to the prompt
+		while (_kbhit())
+			_getch();
+
+		if (best.found)
+			offerPath(best.path, from_code, to_code, client);
+		return;
+	}
+
+	paths::searchResult result;
+	auto const key = keyOf(source, goal, special_case, mode, options.allowedVehicles);
+
+	if (versioned && cache.find(key, result.path))
+	{
+		lastStats.cached = true;
+		std::cout << " Route served from the cache." << std::endl;
+		offerPath(result.path, from_code, to_code, client);
+		return;
+	}
+
+	switch (mode)
+	{
+	case paths::SearchMode::BIDIRECTIONAL:
+		result = searchBidirectional(source, goal, special_case, layerFor(options.allowedVehicles), forwardSpace, backwardSpace);
+		break;
+	case paths::SearchMode::CONTRACTION_HIERARCHY:
+		result = hierarchyFor(options.allowedVehicles).query(graph, source, goal, chSpace);
+		if (!result.found)
+			std::cerr << "No route between the two Centers of Interest uses only the allowed vehicles!" << std::endl;
+		break;
+	default:
+		result = searchUnidirectional(source, goal, special_case, layerFor(options.allowedVehicles), forwardSpace);
+		break;
+	}
+
+	// Reconstruction is timed inside the search, it is reported apart
+	lastStats.time(paths::SearchPhase::SEARCH) = msSince(searching) - result.reconstructionMs;
+	lastStats.time(paths::SearchPhase::RECONSTRUCTION) = result.reconstructionMs;
+	lastStats.expanded = result.expanded;
+
+	if (mode == paths::SearchMode::BIDIRECTIONAL)
+	{
+		countFrontier(forwardSpace);
+		countFrontier(backwardSpace);
+	}
+	else if (mode != paths::SearchMode::CONTRACTION_HIERARCHY)
+	{
+		countFrontier(forwardSpace);
+	}
+
+	if (!result.found)
+		return;
+
+	if (versioned)
+		cache.insert(key, result.path);
+
+	offerPath(result.path, from_code, to_code, client);
+}
+
+std::vector<paths::searchResult> Pathfinder::pathfindBatch(std::vector<paths::routeRequest> const& requests, bool inject, size_t group_size)
+{
+	std::vector<paths::searchResult> results(requests.size());
+
+	if (requests.empty() || !loadGraph())
+		return results;
+
+	/*
+
+	Resolving every CoI code to its Place in a single query
+
+	*/
+	PGresult* res = nullptr;
+	std::string ids = "{";
+	for (size_t i = 0; i < requests.size(); ++i)
+		ids += (i ? "," : "") + std::to_string(requests[i].from) + "," + std::to_string(requests[i].to);
+	ids += "}";
+
+	if (!prepared.execute(query::statements::CENTER_PLACES, { ids }, res))
+	{
+		std::cerr << "Could not resolve the Centers of Interest of the batch, aborting!" << std::endl;
+		PQclear(res);
+		return results;
+	}
+
+	query::resultView centers(res);
+	auto const coi_ids = centers.get<int64_t>(0);
+	auto const place_ids = centers.get<int64_t>(1);
+
+	std::unordered_map<int64_t, uint32_t> nodeOf;
+	for (int row = 0; row < centers.rows(); ++row)
+		nodeOf.emplace(coi_ids[row], graph.indexOf(place_ids[row]));
+	PQclear(res);
+
+	auto lookup = [&](int64_t coi) {
+		auto it = nodeOf.find(coi);
+		return it == nodeOf.end() ? paths::GraphSnapshot::NO_NODE : it->second;
+	};
+
+	std::vector<std::pair<uint32_t, uint32_t>> endpoints(requests.size());
+	std::vector<bool> cached(requests.size(), false);
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		endpoints[i] = { lookup(requests[i].from), lookup(requests[i].to) };
+
+		if (endpoints[i].first == paths::GraphSnapshot::NO_NODE || endpoints[i].second == paths::GraphSnapshot::NO_NODE)
+		{
+			std::cerr << "Request " << i << ": one of the Centers of Interest does not exist or lies on an unknown place, skipped." << std::endl;
+			continue;
+		}
+
+		auto key = keyOf(endpoints[i].first, endpoints[i].second, requests[i].specialCase, paths::SearchMode::BIDIRECTIONAL, requests[i].options.allowedVehicles);
+		cached[i] = results[i].found = versioned && cache.find(key, results[i].path);
+
+		// Workers only read the layers, every one the batch needs is built up front
+		if (!cached[i])
+			layerFor(requests[i].options.allowedVehicles);
+	}
+
+	/*
+
+	Searching, workers pull the next request index until the batch is exhausted
+
+	*/
+	std::atomic<size_t> next{ 0 };
+	auto worker = [&]() {
+		paths::SearchContext forward;
+		paths::SearchContext backward;
+
+		for (size_t i = next++; i < requests.size(); i = next++)
+		{
+			auto [source, goal] = endpoints[i];
+			if (!cached[i] && source != paths::GraphSnapshot::NO_NODE && goal != paths::GraphSnapshot::NO_NODE)
+				results[i] = searchBidirectional(source, goal, requests[i].specialCase, layers[requests[i].options.allowedVehicles & paths::ALL_VEHICLES], forward, backward);
+		}
+	};
+
+	size_t const nWorkers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), requests.size()));
+	std::vector<std::thread> pool;
+	pool.reserve(nWorkers - 1);
+	for (size_t t = 1; t < nWorkers; ++t)
+		pool.emplace_back(worker);
+	worker();
+	for (auto& thread : pool)
+		thread.join();
+
+	if (versioned)
+	{
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			if (results[i].found && !cached[i])
+				cache.insert(keyOf(endpoints[i].first, endpoints[i].second, requests[i].specialCase, paths::SearchMode::BIDIRECTIONAL, requests[i].options.allowedVehicles), results[i].path);
+		}
+	}
+
+	if (!inject)
+		return results;
+
+	/*
+
+	Injecting, group_size routes per transaction
+
+	*/
+	size_t injected = 0;
+	group_size = std::max<size_t>(1, group_size);
+
+	for (size_t first = 0; first < requests.size(); first += group_size)
+	{
+		size_t last = std::min(first + group_size, requests.size());
+		size_t pending = 0;
+		query::transaction group(conn);
+		bool failed = !group.isOpen();
+
+		for (size_t i = first; i < last && !failed; ++i)
+		{
+			if (!results[i].found)
+				continue;
+
+			failed = !query::executeQuery(injectQuery(results[i].path, requests[i].from, requests[i].to, requests[i].client).c_str(), res, conn);
+			PQclear(res);
+			++pending;
+		}
+
+		// A failed statement aborts the transaction, leaving the scope then rolls the whole group back
+		if (!failed)
+			failed = !group.commit();
+
+		if (failed)
+			std::cerr << "\n An error has occurred while injecting requests " << first << " to " << last - 1 << ", none of them was stored." << std::endl;
+		else
+			injected += pending;
+	}
+
+	std::cout << " " << injected << " routes injected." << std::endl;
+	return results;
+}
+
+bool Pathfinder::readBatch(std::string const& file, std::vector<paths::routeRequest>& requests)
+{
+	std::ifstream in(file);
+
+	if (!in)
+	{
+		std::cerr << "Could not open " << file << "!" << std::endl;
+		return false;
+	}
+
+	std::string line;
+	for (size_t number = 1; std::getline(in, line); ++number)
+	{
+		if (line.empty() || line.front() == '#')
+			continue;
+
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::stringstream fields(line);
+
+		paths::routeRequest request{};
+		if (!(fields >> request.from >> request.to >> request.client))
+		{
+			std::cerr << "Line " << number << " of " << file << " is not a valid \"from,to,client[,special_case[,allowed_vehicles]]\" entry!" << std::endl;
+			return false;
+		}
+
+		int vehicles = paths::ALL_VEHICLES;
+		if (fields >> request.specialCase)
+			fields >> vehicles;
+		request.options.allowedVehicles = static_cast<char>(vehicles & paths::ALL_VEHICLES);
+
+		requests.push_back(request);
+	}
+
+	return true;
+}
+
+std::vector<paths::routeRepair> Pathfinder::replanRoutes()
+{
+	std::vector<paths::routeRepair> repaired;
+
+	if (!loadGraph())
+		return repaired;
+
+	/*
+
+	Every stored route with its legs in order, and the shipments still travelling on them
+
+	*/
+	// Read together, so a shipment never points to a route whose legs were read before it changed
+	query::readSnapshot snapshot(conn);
+
+	PGresult* res = nullptr;
+	if (!query::executeQuery("SELECT \"RouteCode\", \"PlaceACode\", \"PlaceBCode\", \"AllowedVehicle\" FROM public.\"Contains\" ORDER BY \"RouteCode\", \"Order\";",
+		res, conn, query::resultFormat::BINARY))
+	{
+		std::cerr << "Could not read the stored routes, aborting!" << std::endl;
+		PQclear(res);
+		return repaired;
+	}
+
+	struct storedLeg
+	{
+		uint32_t from;
+		uint32_t to;
+		paths::VehicleType vehicle;
+	};
+
+	query::resultView legs(res);
+	auto const route_codes = legs.get<int64_t>(0);
+	auto const from_places = legs.get<int64_t>(1);
+	auto const to_places = legs.get<int64_t>(2);
+	auto const vehicles = legs.get<std::string_view>(3);
+
+	std::map<int64_t, std::vector<storedLeg>> routes;
+	for (int row = 0; row < legs.rows(); ++row)
+		routes[route_codes[row]].push_back({ graph.indexOf(from_places[row]), graph.indexOf(to_places[row]), paths::toVehicle(vehicles[row]) });
+	PQclear(res);
+
+	res = nullptr;
+	if (!query::executeQuery("SELECT \"ID\", \"RouteCode\" FROM public.\"Shipment\" WHERE NOT \"isHistorical\" AND \"RouteCode\" IS NOT NULL ORDER BY \"ID\";",
+		res, conn, query::resultFormat::BINARY))
+	{
+		std::cerr << "Could not read the active shipments, aborting!" << std::endl;
+		PQclear(res);
+		return repaired;
+	}
+
+	query::resultView active(res);
+	auto const shipment_ids = active.get<int64_t>(0);
+	auto const shipment_routes = active.get<int64_t>(1);
+
+	std::unordered_map<int64_t, std::vector<int64_t>> shipments;
+	for (int row = 0; row < active.rows(); ++row)
+		shipments[shipment_routes[row]].push_back(shipment_ids[row]);
+	PQclear(res);
+	snapshot.commit();
+
+	// The changes are consumed here, the next call reports what happens from now on
+	auto const changes = std::move(changedConnections);
+	changedConnections.clear();
+
+	/*
+
+	The kept searches learn about every change, deleted routes lose theirs
+
+	*/
+	for (auto it = repairs.begin(); it != repairs.end();)
+	{
+		if (routes.find(it->first) == routes.end())
+		{
+			it = repairs.erase(it);
+			continue;
+		}
+
+		// Changes of a vehicle the route may not use cannot move its costs
+		char const vehicles = it->second.getAllowedVehicles();
+		for (auto const& change : changes)
+		{
+			if (std::get<2>(change.first) & vehicles)
+				it->second.connectionChanged(graph, layerFor(vehicles), std::get<0>(change.first), std::get<1>(change.first));
+		}
+		++it;
+	}
+
+	for (auto const& [route, legs] : routes)
+	{
+		double previous = 0.0;
+		double current = 0.0;
+		bool affected = false;
+
+		// "Route" keeps no options, the vehicles its legs travel on are the ones a repair may use
+		char vehicles = 0;
+
+		for (auto const& leg : legs)
+		{
+			vehicles |= leg.vehicle;
+
+			uint32_t const edge = (leg.from == paths::GraphSnapshot::NO_NODE || leg.to == paths::GraphSnapshot::NO_NODE)
+				? paths::GraphSnapshot::NO_EDGE : graph.findEdge(leg.from, leg.to, leg.vehicle);
+			double const now = (edge == paths::GraphSnapshot::NO_EDGE) ? paths::IncrementalSearch::INF : graph.distance(edge);
+
+			auto change = changes.find(std::make_tuple(leg.from, leg.to, leg.vehicle));
+			affected = affected || change != changes.end() || now == paths::IncrementalSearch::INF;
+
+			previous += (change != changes.end()) ? change->second : now;
+			current += now;
+		}
+
+		auto active = shipments.find(route);
+		if (!affected && active == shipments.end())
+			continue;
+
+		uint32_t const source = legs.front().from;
+		uint32_t const goal = legs.back().to;
+		if (source == paths::GraphSnapshot::NO_NODE || goal == paths::GraphSnapshot::NO_NODE)
+		{
+			std::cerr << "Route " << route << " starts or ends on a place the graph does not know, skipped." << std::endl;
+			continue;
+		}
+
+		// Searches are kept for routes still in use or already hit once, the rest are not worth the memory
+		auto& search = repairs[route];
+		if (!search.isStarted() || search.getSource() != source || search.getGoal() != goal || search.getAllowedVehicles() != vehicles)
+			search.start(graph, source, goal, vehicles);
+
+		paths::searchResult result = search.compute(graph, layerFor(vehicles));
+
+		if (!affected)
+			continue;
+
+		repaired.push_back({ route, active == shipments.end() ? std::vector<int64_t>{} : active->second, previous, current, std::move(result) });
+	}
+
+	return repaired;
+}
+
+bool Pathfinder::distanceMatrix(int64_t company, paths::pathOptions const& options, paths::DistanceMatrix& matrix)
+{
+	if (!loadGraph())
+		return false;
+
+	PGresult* res = nullptr;
+	bool const read = (company != 0)
+		? prepared.execute(query::statements::COMPANY_CENTER_PLACES, { std::to_string(company) }, res)
+		: prepared.execute(query::statements::ALL_CENTER_PLACES, {}, res);
+
+	if (!read)
+	{
+		std::cerr << "Could not read the Centers of Interest, aborting!" << std::endl;
+		PQclear(res);
+		return false;
+	}
+
+	query::resultView found(res);
+	auto const coi_ids = found.get<int64_t>(0);
+	auto const place_ids = found.get<int64_t>(1);
+
+	std::vector<int64_t> centers(coi_ids.begin(), coi_ids.end());
+	std::vector<uint32_t> nodes(centers.size());
+	for (int row = 0; row < found.rows(); ++row)
+		nodes[row] = graph.indexOf(place_ids[row]);
+	PQclear(res);
+
+	matrix.compute(graph, hierarchyFor(options.allowedVehicles), centers, nodes, graphVersion);
+	return true;
+}
+
+bool Pathfinder::reachable(int64_t coi_code, paths::ReachMetric metric, double budget, paths::pathOptions const& options,
+	std::vector<paths::reachablePlace>& places)
+{
+	int64_t place = 0;
+
+	if (!resolvePlace(coi_code, place, "starting") || !loadGraph())
+		return false;
+
+	uint32_t const source = graph.indexOf(place);
+	if (source == paths::GraphSnapshot::NO_NODE)
+	{
+		std::cerr << "The starting Center of Interest lies on an unknown place, aborting!" << std::endl;
+		return false;
+	}
+
+	reachability.search(graph, layerFor(options.allowedVehicles), source, metric, budget, forwardSpace, places);
+	return true;
+}
+
+void Pathfinder::benchmark(int64_t from_code, int64_t to_code, short special_case)
+{
+	uint32_t source = 0;
+	uint32_t goal = 0;
+
+	if (!prepare(from_code, to_code, source, goal))
+		return;
+
+	auto report = [](const char* name, paths::searchResult const& result, double ms) {
+		std::cout << " " << name << ": " << result.expanded << " nodes expanded, " << ms << " ms";
+		if (result.found)
+			std::cout << ", " << result.path.size() << " legs, distance " << (result.path.empty() ? 0.0 : result.path.back().distance);
+		else
+			std::cout << ", no path";
+		std::cout << std::endl;
+	};
+
+	using clock = std::chrono::steady_clock;
+	auto elapsed = [](clock::time_point from, clock::time_point to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+
+	auto frontier = [](paths::SearchContext const& ctx) {
+		auto const& ops = ctx.getCounters();
+		std::cout << "    frontier: " << ops.pushes << " pushes, " << ops.decreases << " decrease-keys, " << ops.pops << " pops" << std::endl;
+	};
+
+	std::cout << "\n Search benchmark over " << graph.nodeCount() << " places and " << graph.edgeCount() << " connections:" << std::endl;
+
+	auto start = clock::now();
+	auto const& everything = layerFor(paths::ALL_VEHICLES);
+	auto uni = searchUnidirectional(source, goal, special_case, everything, forwardSpace);
+	auto mid = clock::now();
+	report("Unidirectional A*", uni, elapsed(start, mid));
+	frontier(forwardSpace);
+
+	mid = clock::now();
+	auto bid = searchBidirectional(source, goal, special_case, everything, forwardSpace, backwardSpace);
+	auto end = clock::now();
+	report("Bidirectional A* ", bid, elapsed(mid, end));
+	frontier(forwardSpace);
+	frontier(backwardSpace);
+
+	if (uni.expanded > 0)
+		std::cout << " Bidirectional expanded " << (100.0 * bid.expanded) / uni.expanded << "% of the unidirectional nodes." << std::endl;
+
+	// Every route the anytime search would show, with the time it would show up at
+	std::cout << " Anytime A*:" << std::endl;
+	start = clock::now();
+	searchAnytime(source, goal, special_case, everything, forwardSpace, [&](paths::searchResult const& route, double suboptimality) {
+		std::cout << "    " << elapsed(start, clock::now()) << " ms: cost " << route.cost << " (bound " << suboptimality << "), "
+			<< route.expanded << " nodes expanded so far" << std::endl;
+		return true;
+	});
+
+	// Yen with the default number of routes, spur searches share the backward costs
+	start = clock::now();
+	auto alternatives = searchAlternatives(source, goal, paths::pathOptions{}.alternatives, special_case, everything, forwardSpace, backwardSpace);
+	end = clock::now();
+
+	std::cout << " Alternatives (Yen): " << alternatives.size() << " routes, " << (alternatives.empty() ? 0 : alternatives.back().expanded)
+		<< " nodes expanded, " << elapsed(start, end) << " ms" << std::endl;
+
+	size_t pareto_expanded = 0;
+	start = clock::now();
+	auto front = searchPareto(source, goal, everything, pareto_expanded);
+	end = clock::now();
+
+	std::cout << " Pareto search: " << pareto_expanded << " labels expanded, " << elapsed(start, end) << " ms, "
+		<< front.size() << " non-dominated routes" << std::endl;
+
+	// The hierarchy minimises plain distance over every vehicle, special options do not apply to it
+	auto& hierarchy = hierarchies[paths::ALL_VEHICLES];
+	hierarchy.clear();
+
+	start = clock::now();
+	hierarchy.build(graph, paths::ALL_VEHICLES);
+	mid = clock::now();
+
+	constexpr int QUERY_RUNS = 100;
+	paths::searchResult ch;
+	for (int run = 0; run < QUERY_RUNS; ++run)
+		ch = hierarchy.query(graph, source, goal, chSpace);
+	end = clock::now();
+
+	std::cout << " Contraction Hierarchy: preprocessing " << elapsed(start, mid) << " ms, " << hierarchy.shortcutCount() << " shortcuts, "
+		<< hierarchy.memoryBytes() / 1024.0 << " KiB" << std::endl;
+	report("CH query (avg)   ", ch, elapsed(mid, end) / QUERY_RUNS);
+
+	// The same searches with the straight line alone and with landmarks
+	auto const& landmarks = graph.getLandmarks();
+	std::cout << "\n Heuristics (average of " << QUERY_RUNS << " runs, " << landmarks.size() << " landmarks, "
+		<< landmarks.memoryBytes() / 1024.0 << " KiB):" << std::endl;
+
+	auto compare = [&](const char* name, auto&& search) {
+		paths::searchResult timed[2];
+		double ms[2];
+
+		for (int kind = 0; kind < 2; ++kind)
+		{
+			auto from = clock::now();
+			for (int run = 0; run < QUERY_RUNS; ++run)
+				timed[kind] = search(kind == 1);
+			ms[kind] = elapsed(from, clock::now()) / QUERY_RUNS;
+		}
+
+		std::cout << " " << name << ": " << timed[0].expanded << " -> " << timed[1].expanded << " nodes expanded, "
+			<< ms[0] << " -> " << ms[1] << " ms (" << paths::EuclideanBound::name << " -> " << paths::LandmarkBound::name << ")" << std::endl;
+	};
+
+	paths::withPolicy(special_case, [&](auto const& exact) {
+		paths::Weighted<std::decay_t<decltype(exact)>> weighted{ exact, COMPARISON_WEIGHT };
+
+		compare("Unidirectional A*, exact   ", [&](bool alt) {
+			return alt ? unidirectional<paths::LandmarkBound>(source, goal, exact, everything, forwardSpace)
+				: unidirectional<paths::EuclideanBound>(source, goal, exact, everything, forwardSpace);
+		});
+		compare("Unidirectional A*, weighted", [&](bool alt) {
+			return alt ? unidirectional<paths::LandmarkBound>(source, goal, weighted, everything, forwardSpace)
+				: unidirectional<paths::EuclideanBound>(source, goal, weighted, everything, forwardSpace);
+		});
+		compare("Bidirectional A*           ", [&](bool alt) {
+			return alt ? bidirectional<paths::LandmarkBound>(source, goal, exact, everything, forwardSpace, backwardSpace)
+				: bidirectional<paths::EuclideanBound>(source, goal, exact, everything, forwardSpace, backwardSpace);
+		});
+	});
+
+	// Every special option on the same pair, exact and with the weight the unidirectional mode used to search with
+	std::cout << "\n Cost policies (unidirectional A*, average of " << QUERY_RUNS << " runs, exact / weighted by " << COMPARISON_WEIGHT << "):" << std::endl;
+
+	for (short policy = 0; policy < paths::POLICY_COUNT; ++policy)
+	{
+		paths::withPolicy(policy, [&](auto const& exact) {
+			paths::Weighted<std::decay_t<decltype(exact)>> weighted{ exact, COMPARISON_WEIGHT };
+
+			auto measure = [&](auto const& pricing) {
+				paths::searchResult priced;
+
+				auto from = clock::now();
+				for (int run = 0; run < QUERY_RUNS; ++run)
+					priced = unidirectional<paths::LandmarkBound>(source, goal, pricing, everything, forwardSpace);
+				auto to = clock::now();
+
+				double fee = 0.0;
+				for (auto const& leg : priced.path)
+					fee += leg.fee;
+
+				std::cout << " " << elapsed(from, to) / QUERY_RUNS << " ms, " << priced.expanded << " expanded";
+				if (priced.found)
+					std::cout << ", cost " << priced.cost << ", distance " << (priced.path.empty() ? 0.0 : priced.path.back().distance) << ", fee " << fee;
+			};
+
+			std::cout << " " << policy << " " << exact.name << ":";
+			measure(exact);
+			std::cout << "  /";
+			measure(weighted);
+			std::cout << std::endl;
+		});
+	}
+
+	// Restricted searches on the same pair, each on the layer of its vehicles
+	std::cout << "\n Vehicle layers (bidirectional A*, special option " << special_case << "):" << std::endl;
+
+	for (char vehicles = 1; vehicles <= paths::ALL_VEHICLES; ++vehicles)
+	{
+		start = clock::now();
+		auto const& layer = layerFor(vehicles);
+		mid = clock::now();
+		auto restricted = searchBidirectional(source, goal, special_case, layer, forwardSpace, backwardSpace);
+		end = clock::now();
+
+		std::cout << " " << ((vehicles & paths::PLANE) ? 'P' : '-') << ((vehicles & paths::SHIP) ? 'S' : '-') << ((vehicles & paths::CAR) ? 'C' : '-')
+			<< ": " << layer.edgeCount() << " connections, built in " << elapsed(start, mid) << " ms,";
+		report(" search", restricted, elapsed(mid, end));
+	}
+}
+
+void Pathfinder::assignGraph(std::vector<paths::placeRow> const& place_rows, std::vector<paths::connectionRow> const& connection_rows)
+{
+	invalidateGraph();
+	graph.assign(place_rows, connection_rows);
+	graph.placeLandmarks(paths::LandmarkTable::DEFAULT_COUNT);
+
+	graphVersion = 0;
+	versioned = false;
+	snapshotStale = false;
+	snapshotPath.clear();
+}
+
+paths::searchResult Pathfinder::searchPlaces(int64_t from_place, int64_t to_place, short special_case, paths::SearchMode mode, char allowed_vehicles)
+{
+	uint32_t const source = graph.indexOf(from_place);
+	uint32_t const goal = graph.indexOf(to_place);
+
+	if (source == paths::GraphSnapshot::NO_NODE || goal == paths::GraphSnapshot::NO_NODE)
+		return {};
+
+	auto const& layer = layerFor(allowed_vehicles);
+
+	switch (mode)
+	{
+	case paths::SearchMode::UNIDIRECTIONAL:
+		return searchUnidirectional(source, goal, special_case, layer, forwardSpace);
+	case paths::SearchMode::BIDIRECTIONAL:
+		return searchBidirectional(source, goal, special_case, layer, forwardSpace, backwardSpace);
+	case paths::SearchMode::ANYTIME:
+		return searchAnytime(source, goal, special_case, layer, forwardSpace, [](paths::searchResult const&, double) { return true; });
+	case paths::SearchMode::ALTERNATIVES:
+	{
+		auto routes = searchAlternatives(source, goal, 1, special_case, layer, forwardSpace, backwardSpace);
+		return routes.empty() ? paths::searchResult{} : std::move(routes.front());
+	}
+	default:
+		return {};
+	}
+}
+
+size_t Pathfinder::chooseRoute(std::vector<paths::paretoRoute> const& front)
+{
+	std::cout << " " << front.size() << " non-dominated routes found:" << std::endl;
+	for (size_t i = 0; i < front.size(); ++i)
+	{
+		std::cout << " (" << i << "): distance " << front[i].distance << ", fee " << front[i].fee << ", "
+			<< front[i].modeChanges << " vehicle changes, " << front[i].path.size() << " legs" << std::endl;
+	}
 
-	void findConnections(PGresult*& res, std::vector<paths::destination>& results)
+	return askRoute(front.size());
+}
+
+size_t Pathfinder::chooseAlternative(std::vector<paths::searchResult> const& routes)
+{
+	std::cout << " " << routes.size() << " alternative routes found (" << routes.back().expanded << " places expanded):" << std::endl;
+	for (size_t i = 0; i < routes.size(); ++i)
 	{
-		//Dictionary that maps NodeB -> ( { dist, vei, fee }, { dist, vei, fee } )
-		std::map<int64_t, std::vector<pathtup>> distances;
-		size_t nRows = PQntuples(res);
+		double fee = 0.0;
+		double travelled = 0.0;
+		double byVehicle[paths::ALL_VEHICLES + 1] = {};
 
-		if (nRows == 0)
-			return;
+		// Leg distances are cumulative
+		for (auto const& leg : routes[i].path)
+		{
+			fee += leg.fee;
+			byVehicle[leg.vehicle] += leg.distance - travelled;
+			travelled = leg.distance;
+		}
+
+		std::cout << " (" << i << "): cost " << routes[i].cost << ", distance " << travelled << ", fee " << fee << ", "
+			<< routes[i].path.size() << " legs (plane " << byVehicle[paths::PLANE] << ", ship " << byVehicle[paths::SHIP]
+			<< ", car " << byVehicle[paths::CAR] << ")" << std::endl;
+	}
+
+	return askRoute(routes.size());
+}
+
+size_t Pathfinder::askRoute(size_t count)
+{
+	std::string input;
+	std::cout << " Which route do you want to look at? (anything else to give up)" << std::endl;
+	std::cin >> input;
+
+	char* end = nullptr;
+	int64_t chosen = _strtoi64(input.c_str(), &end, 10);
+
+	if (end == input.c_str() || *end != '\0' || chosen < 0 || static_cast<size_t>(chosen) >= count)
+		return count;
+
+	return static_cast<size_t>(chosen);
+}
+
+paths::ContractionHierarchy const& Pathfinder::hierarchyFor(char allowed_vehicles)
+{
+	auto& hierarchy = hierarchies[allowed_vehicles & paths::ALL_VEHICLES];
+
+	if (!hierarchy.isBuilt())
+	{
+		std::cout << " Building the Contraction Hierarchy for this vehicle combination, this is done once per graph..." << std::endl;
+		hierarchy.build(graph, allowed_vehicles & paths::ALL_VEHICLES);
+	}
+
+	return hierarchy;
+}
+
+paths::VehicleLayer const& Pathfinder::layerFor(char allowed_vehicles)
+{
+	auto& layer = layers[allowed_vehicles & paths::ALL_VEHICLES];
+
+	if (!layer.isBuilt())
+		layer.build(graph, allowed_vehicles & paths::ALL_VEHICLES);
+
+	return layer;
+}
+
+/**
+ * Multi-label search (Martins' label-setting algorithm) over (distance, total fee, vehicle changes).
+ *
+ * Every place keeps a bag of labels, one per partial route that is not dominated by another one reaching
+ * the same place. Since the change count depends on the vehicle a route arrives with, a label only dominates
+ * another one with a different last vehicle if it stays no worse even after paying one extra change.
+ * Labels are settled in lexicographic order of (distance + lower bound to the goal, fee, changes), and a
+ * label is dropped as soon as a route already at the goal beats it even with the lower bound added.
+ * Unlike the other modes every parallel connection is relaxed, a longer one may be cheaper.
+ */
+std::vector<paths::paretoRoute> Pathfinder::searchPareto(uint32_t source, uint32_t goal, paths::VehicleLayer const& layer, size_t& expanded)
+{
+	constexpr uint32_t NO_LABEL = UINT32_MAX;
 
-		int64_t from = _strtoi64(PQgetvalue(res, 0, 1), nullptr, 10);
+	struct label
+	{
+		double distance;
+		double fee;
+		uint32_t changes;
+		uint32_t node;
+		uint32_t parent;	// label this one extends
+		uint32_t edge;		// edge taken from the parent
+		paths::VehicleType vehicle;
+		bool dead;
+	};
+
+	using entry = std::tuple<double, double, uint32_t, uint32_t>;	// distance + h, fee, changes, label
+	std::priority_queue<entry, std::vector<entry>, std::greater<entry>> frontier;
+
+	paths::LandmarkBound const lower(graph, source, goal);
+
+	std::vector<label> labels;
+	std::vector<std::vector<uint32_t>> bags(graph.nodeCount());
+	std::vector<uint32_t> arrived;	// labels settled at the goal, mutually non-dominated
 
-		for (size_t i = 0; i < nRows; ++i)
+	auto dominates = [](label const& a, label const& b) {
+		uint32_t extra = (a.vehicle != b.vehicle && a.parent != NO_LABEL) ? 1 : 0;
+		return a.distance <= b.distance && a.fee <= b.fee && a.changes + extra <= b.changes;
+	};
+
+	// A goal label beats every extension of 'l' if it is no worse than the best 'l' could still achieve
+	auto beatenAtGoal = [&](label const& l) {
+		double bound = l.distance + lower.toGoal(l.node);
+		for (auto const g : arrived)
 		{
-			int64_t to   =	_strtoi64(PQgetvalue(res, i, 2), nullptr, 10);
-			auto vCode   =	std::string(PQgetvalue(res, i, 0));
-			auto fee     =	_strtoi64(PQgetvalue(res, i, 3), nullptr, 10);
+			label const& best = labels[g];
+			if (best.distance <= bound && best.fee <= l.fee && best.changes <= l.changes)
+				return true;
+		}
+		return false;
+	};
+
+	labels.push_back({ 0.0, 0.0, 0, source, NO_LABEL, NO_LABEL, paths::CAR, false });
+	bags[source].push_back(0);
+	frontier.emplace(lower.toGoal(source), 0.0, 0, 0);
+
+	while (!frontier.empty())
+	{
+		uint32_t current = std::get<3>(frontier.top());
+		frontier.pop();
+
+		if (labels[current].dead)
+			continue;
+
+		label const settled = labels[current];
+
+		if (beatenAtGoal(settled))
+			continue;
 
-			VehicleType vType = (vCode == "Car") ? CAR : ((vCode == "Plane") ? PLANE : SHIP);
+		++expanded;
 
-			double distance = std::stod(PQgetvalue(res, i, 4));
-			
-			distances[to].emplace_back(distance, vType, fee);
+		if (settled.node == goal)
+		{
+			arrived.push_back(current);
+			continue;
 		}
 
-		for (auto& [key, vec] : distances)
+		for (uint32_t i = layer.outBegin(settled.node); i < layer.outEnd(settled.node); ++i)
 		{
-			std::sort(vec.begin(), vec.end());
-			results.emplace_back( std::get<1>(vec.front()), from, key, std::get<0>(vec.front()), std::get<2>(vec.front()), 0.0);
+			uint32_t edge = layer.outEdge(i);
+			uint32_t v = graph.target(edge);
+			paths::VehicleType vehicle = graph.vehicle(edge);
+			bool changed = settled.parent != NO_LABEL && vehicle != settled.vehicle;
+
+			label next{ settled.distance + graph.distance(edge), settled.fee + graph.fee(edge), settled.changes + (changed ? 1u : 0u),
+				v, current, edge, vehicle, false };
+
+			auto& bag = bags[v];
+			if (std::any_of(bag.begin(), bag.end(), [&](uint32_t other) { return dominates(labels[other], next); }))
+				continue;
+
+			if (beatenAtGoal(next))
+				continue;
+
+			// The newcomer survives: retire whatever it dominates, settled labels included
+			auto firstDominated = std::remove_if(bag.begin(), bag.end(), [&](uint32_t other) {
+				if (!dominates(next, labels[other])) return false;
+				labels[other].dead = true;
+				return true;
+			});
+			bag.erase(firstDominated, bag.end());
+
+			uint32_t id = static_cast<uint32_t>(labels.size());
+			labels.push_back(next);
+			bag.push_back(id);
+			frontier.emplace(next.distance + lower.toGoal(v), next.fee, next.changes, id);
 		}
 	}
+
+	// Retired parents are fine to walk through, the chain of a live label is still a valid route
+	std::vector<paths::paretoRoute> front;
+	std::vector<uint32_t> edges;
+
+	for (auto const id : arrived)
+	{
+		if (labels[id].dead)
+			continue;
+
+		edges.clear();
+		for (uint32_t l = id; labels[l].parent != NO_LABEL; l = labels[l].parent)
+			edges.push_back(labels[l].edge);
+		std::reverse(edges.begin(), edges.end());
+
+		paths::paretoRoute route;
+		route.distance = labels[id].distance;
+		route.fee = labels[id].fee;
+		route.modeChanges = labels[id].changes;
+		graph.toLegs(edges, route.path);
+		front.push_back(std::move(route));
+	}
+
+	std::sort(front.begin(), front.end(), [](paths::paretoRoute const& a, paths::paretoRoute const& b) {
+		return std::tie(a.distance, a.fee, a.modeChanges) < std::tie(b.distance, b.fee, b.modeChanges);
+	});
+
+	return front;
 }
 
+paths::searchResult Pathfinder::searchUnidirectional(uint32_t source, uint32_t goal, short special_case, paths::VehicleLayer const& layer, paths::SearchContext& ctx) const
+{
+	// Landmarks bound the detours well enough that the exact search expands less than the inflated straight line did
+	return paths::withPolicy(special_case, [&](auto const& policy) { return unidirectional<paths::LandmarkBound>(source, goal, policy, layer, ctx); });
+}
 
-void Pathfinder::pathfind(int64_t from_code, int64_t to_code, int64_t client, short special_case)
+template<class Bound, class Policy>
+paths::searchResult Pathfinder::unidirectional(uint32_t source, uint32_t goal, Policy const& policy, paths::VehicleLayer const& layer, paths::SearchContext& ctx) const
 {
+	paths::searchResult result;
+	ctx.reset(graph.nodeCount());
 
-	/* We set our Priority Queue*/
-	static auto cmp = [](paths::destination const& left, paths::destination const& right) { return (left.distance + left.heuristic) > (right.distance + right.heuristic); };
-	static std::priority_queue < paths::destination, std::vector<paths::destination>, decltype(cmp)> queue(cmp);
-	while (!queue.empty()) queue.pop();
+	Bound const bound(graph, source, goal);
+	std::vector<uint32_t> edges;
+	std::vector<uint32_t> neighbours;
+	std::vector<double> prices;
+	std::vector<double> heuristics;
 
-	/*
-	
-	Initializing CoI codes to Place Codes
-	
-	*/
-	static std::stringstream querybuilder;
-	querybuilder << "SELECT \"CenterOfInterest\".\"PlaceCode\" FROM public.\"CenterOfInterest\" WHERE \"CenterOfInterest\".\"ID\" = " << from_code << ";";
+	ctx.relax(source, 0.0, paths::SearchContext::NO_EDGE);
+	ctx.push(0.0, source);
 
-	if (!(query::atomicQuery(querybuilder.str().c_str(), res, conn) && PQntuples(res) > 0))
+	while (!ctx.empty())
 	{
-		std::cerr << "The first Center of Interest does not exist, aborting!" << std::endl;
-		PQclear(res);
-		querybuilder.str(std::string());
-		return;
-	}
+		uint32_t u = ctx.pop().second;
+		ctx.close(u);
+		++result.expanded;
 
-	const auto placecode_from = std::string(PQgetvalue(res, 0, 0));
-	std::unordered_set<int64_t> reached{ _strtoi64(placecode_from.c_str(), nullptr, 10) };
-	query::atomicQuery(querybuilder.str().c_str(), res, conn);
-	querybuilder.str(std::string());
+		if (u == goal)
+			break;
 
-	PQclear(res);
+		// Edges are sorted by (target, distance) and layers keep that order, so parallel connections come in a run.
+		// The shortest one need not be the cheapest under the policy: the whole run is priced and its cheapest kept
+		edges.clear();
+		neighbours.clear();
+		prices.clear();
+		for (uint32_t i = layer.outBegin(u); i < layer.outEnd(u); ++i)
+		{
+			uint32_t edge = layer.outEdge(i);
+			uint32_t v = graph.target(edge);
+			double const price = policy.cost(graph, edge);
+
+			if (!neighbours.empty() && neighbours.back() == v)
+			{
+				if (price < prices.back())
+				{
+					edges.back() = edge;
+					prices.back() = price;
+				}
+				continue;
+			}
+
+			edges.push_back(edge);
+			neighbours.push_back(v);
+			prices.push_back(price);
+		}
+
+		heuristics.resize(neighbours.size());
+		bound.toGoalBatch(neighbours.data(), neighbours.size(), heuristics.data());
 
-	querybuilder << "SELECT \"CenterOfInterest\".\"PlaceCode\" FROM public.\"CenterOfInterest\" WHERE \"CenterOfInterest\".\"ID\" = " << to_code << ";";
+		for (size_t n = 0; n < neighbours.size(); ++n)
+		{
+			uint32_t const v = neighbours[n];
+			uint32_t const edge = edges[n];
+
+			if (ctx.closed(v))
+				continue;
+
+			double g = ctx.cost(u) + prices[n];
+			if (g < ctx.cost(v))
+			{
+				ctx.relax(v, g, edge);
+				ctx.push(g + policy.heuristic(heuristics[n]), v);
+			}
+		}
+	}
 
-	if (!(query::atomicQuery(querybuilder.str().c_str(), res, conn) && PQntuples(res) > 0))
+	if (!ctx.closed(goal))
 	{
-		std::cerr << "The second Center of Interest does not exist, aborting!" << std::endl;
-		PQclear(res);
-		querybuilder.str(std::string());
-		return;
+		std::cerr << "A* could not connect the two Centers of Interest!" << std::endl;
+		return result;
 	}
 
-	querybuilder.str(std::string());
+	// Reconstruct, walking the parent edges back from the goal
+	auto const reconstructing = std::chrono::steady_clock::now();
+	std::vector<uint32_t> legs;
+	for (uint32_t v = goal; v != source; v = graph.source(ctx.parent(v)))
+		legs.push_back(ctx.parent(v));
+	std::reverse(legs.begin(), legs.end());
 
-	const auto placecode_to = std::string(PQgetvalue(res, 0, 0));
-	PQclear(res);
+	graph.toLegs(legs, result.path);
+	result.reconstructionMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - reconstructing).count();
 
-	std::vector<paths::destination> destinations;
+	result.cost = ctx.cost(goal);
+	result.found = true;
+	return result;
+}
 
-	//Utility printer
-	CLprinter printer;
+paths::searchResult Pathfinder::searchAnytime(uint32_t source, uint32_t goal, short special_case, paths::VehicleLayer const& layer,
+	paths::SearchContext& ctx, std::function<bool(paths::searchResult const&, double)> const& improved) const
+{
+	return paths::withPolicy(special_case, [&](auto const& policy) { return anytime<paths::LandmarkBound>(source, goal, policy, layer, ctx, improved); });
+}
+
+/**
+ * ARA*: every pass is a weighted A* that stops as soon as no queued place can beat the goal under the current
+ * weight. A closed place whose cost improves is set aside (it is inconsistent) instead of being expanded again
+ * within the pass; the next pass lowers the weight, requeues those places, rekeys the whole frontier and
+ * reopens the closed set, keeping every cost found so far.
+ *
+ * The bound handed out is cost(goal) / min(g + h) over the frontier and the places set aside, which is at most
+ * the weight and often far below it: no route can cost less than that minimum.
+ */
+template<class Bound, class Policy>
+paths::searchResult Pathfinder::anytime(uint32_t source, uint32_t goal, Policy const& policy, paths::VehicleLayer const& layer,
+	paths::SearchContext& ctx, std::function<bool(paths::searchResult const&, double)> const& improved) const
+{
+	constexpr double INF = paths::SearchContext::INF;
+	constexpr double FINAL_STEP = 1.25;	// weights from here go straight to 1, the last small steps cost more than they show
+
+	paths::searchResult result;
+	ctx.reset(graph.nodeCount());
 
-	queue.emplace(paths::CAR, _strtoi64(placecode_from.c_str(), nullptr, 10), _strtoi64(placecode_from.c_str(), nullptr, 10), 0.0, 0.0, 0.0);
+	Bound const bound(graph, source, goal);
+	auto h = [&](uint32_t v) { return policy.heuristic(bound.toGoal(v)); };
 
-	std::stack<paths::destination> explored;
+	std::vector<uint32_t> inconsistent;
+	double weight = ANYTIME_START_WEIGHT;
+	double reported = INF;
 
-	while(!queue.empty()) {
-		explored.emplace(queue.top());
-		
-		if (explored.top().to == _strtoi64(placecode_to.c_str(), nullptr, 10))
+	ctx.relax(source, 0.0, paths::SearchContext::NO_EDGE);
+	ctx.push(weight * h(source), source);
+
+	for (;;)
+	{
+		// One pass: goal costs are exact once nothing queued has a lower key
+		while (!ctx.empty() && ctx.cost(goal) > ctx.top().first)
 		{
-			break;
+			uint32_t u = ctx.pop().second;
+			ctx.close(u);
+			++result.expanded;
+
+			for (uint32_t i = layer.outBegin(u); i < layer.outEnd(u); ++i)
+			{
+				uint32_t const edge = layer.outEdge(i);
+				uint32_t const v = graph.target(edge);
+
+				double g = ctx.cost(u) + policy.cost(graph, edge);
+				if (g < ctx.cost(v))
+				{
+					ctx.relax(v, g, edge);
+
+					// Places that cannot lead to a cheaper route than the one known are never expanded again
+					double const estimate = h(v);
+					if (g + estimate >= ctx.cost(goal))
+						continue;
+
+					if (ctx.closed(v))
+						inconsistent.push_back(v);
+					else
+						ctx.push(g + weight * estimate, v);
+				}
+			}
+		}
+
+		if (ctx.cost(goal) == INF)
+		{
+			std::cerr << "The anytime search could not connect the two Centers of Interest!" << std::endl;
+			return result;
 		}
 
-		queue.pop();
-		
-		querybuilder << "SELECT * FROM \"Connection\" WHERE \"Connection\".\"PlaceA\" = " << explored.top().to << "; ";
+		double const passWeight = weight;
+		weight = (weight <= FINAL_STEP) ? 1.0 : std::max(1.0, 1.0 + (weight - 1.0) / 2.0);
+
+		// Ready the next pass, the lowest g + h of what is still queued bounds the optimum along the way
+		double lowest = INF;
+		for (auto const v : inconsistent)
+			ctx.push(0.0, v);
+		inconsistent.clear();
+
+		ctx.reopen();
+		ctx.rekey([&](uint32_t v) {
+			double const estimate = h(v);
+			if (ctx.cost(v) + estimate >= ctx.cost(goal))
+				return INF;
+
+			lowest = std::min(lowest, ctx.cost(v) + estimate);
+			return ctx.cost(v) + weight * estimate;
+		});
 
-		if (!(query::atomicQuery(querybuilder.str().c_str(), res, conn)))
+		// Walk the parent edges back from the goal
+		std::vector<uint32_t> legs;
+		for (uint32_t v = goal; v != source; v = graph.source(ctx.parent(v)))
+			legs.push_back(ctx.parent(v));
+		std::reverse(legs.begin(), legs.end());
+
+		result.path.clear();
+		graph.toLegs(legs, result.path);
+		result.cost = ctx.cost(goal);
+		result.found = true;
+
+		double const suboptimality = (passWeight <= 1.0 || lowest >= result.cost) ? 1.0 : std::min(passWeight, result.cost / lowest);
+
+		if (suboptimality <= 1.0)
 		{
-			std::cerr << "An error has occurred while expanding the frontier in our A* algorithm!" << std::endl;
-			PQclear(res);
-			querybuilder.str(std::string());
-			while (!queue.empty()) queue.pop();
-			while (!explored.empty()) explored.pop();
-			destinations.clear();
-			reached.clear();
-			return;
+			improved(result, suboptimality);
+			return result;
 		}
 
-		querybuilder.str(std::string());
-		destinations.clear();
-		findConnections(res, destinations);
+		// A pass that found nothing cheaper only tightened the bound, it is not worth showing
+		if (result.cost < reported)
+		{
+			reported = result.cost;
+			if (!improved(result, suboptimality))
+				return result;
+		}
+	}
+}
+
+/**
+ * Yen's k shortest routes: the spur searches reuse fwd and bwd, each with the places of its root path closed
+ * and the next connection of every route found with that root banned (see the declaration).
+ */
+std::vector<paths::searchResult> Pathfinder::searchAlternatives(uint32_t source, uint32_t goal, size_t count, short special_case,
+	paths::VehicleLayer const& layer, paths::SearchContext& fwd, paths::SearchContext& bwd) const
+{
+	return paths::withPolicy(special_case, [&](auto const& policy) {
+		return alternatives(source, goal, count, policy, layer, fwd, bwd);
+	});
+}
+
+template<class Policy>
+std::vector<paths::searchResult> Pathfinder::alternatives(uint32_t source, uint32_t goal, size_t count, Policy const& policy,
+	paths::VehicleLayer const& layer, paths::SearchContext& fwd, paths::SearchContext& bwd) const
+{
+	struct candidate
+	{
+		std::vector<uint32_t> edges;
+		double cost;
+		size_t deviation;	// index of the first leg that differs from the route it was derived from
+
+		bool operator>(candidate const& other) const { return cost > other.cost; }
+	};
+
+	std::vector<paths::searchResult> routes;
+	size_t expanded = 0;
+
+	if (count == 0)
+		return routes;
+
+	/*
+
+	Exact cost to the goal, searching backwards on the incoming connections until the source is settled
+
+	*/
+	bwd.reset(graph.nodeCount());
+	bwd.relax(goal, 0.0, paths::SearchContext::NO_EDGE);
+	bwd.push(0.0, goal);
+
+	while (!bwd.empty())
+	{
+		uint32_t u = bwd.pop().second;
+		bwd.close(u);
+		++expanded;
+
+		if (u == source)
+			break;
 
-		for (auto& dest : destinations)
+		for (uint32_t i = layer.inBegin(u); i < layer.inEnd(u); ++i)
 		{
-			PQclear(res);
+			uint32_t edge = layer.inEdge(i);
+			uint32_t v = graph.source(edge);
+			if (bwd.closed(v))
+				continue;
 
-			querybuilder << "SELECT * FROM \"distance_places_ints\"(" << dest.to << ", " << placecode_to << ")";
-			query::atomicQuery(querybuilder.str().c_str(), res, conn);
-			querybuilder.str(std::string());
+			double g = bwd.cost(u) + policy.cost(graph, edge);
+			if (g < bwd.cost(v))
+			{
+				bwd.relax(v, g, edge);
+				bwd.push(g, v);
+			}
+		}
+	}
 
-			double mul = 1.0;
+	if (!bwd.closed(source))
+		return routes;
 
-			switch (special_case) {
-			case 1: // Prefer cars
-				if (dest.vehicle != paths::CAR) {
-					mul = 10.0;
-				}
-				break;
-			case 2: // Discourage planes
-				if (dest.vehicle == paths::PLANE) {
-					mul = 100.0;
-				}
-				break;
-			case 3: // Discourage ships
-				if (dest.vehicle == paths::SHIP) {
-					mul = 100.0;
-				}
-				break;
-			case 4: // Less costly
-				mul = 1.0 + dest.fee * 100.0;
-				break;
-			default:
-				break;
+	// Places left out cost at least as much as the source to the goal: the larger of that radius and the
+	// landmark bound is still a consistent heuristic next to the exact costs
+	double const radius = bwd.cost(source);
+	paths::LandmarkBound const bound(graph, source, goal);
+	auto remaining = [&](uint32_t v) {
+		return bwd.closed(v) ? bwd.cost(v) : std::max(radius, policy.heuristic(bound.toGoal(v)));
+	};
+
+	// The backward parents lead from every place to the goal along a cheapest route, the first route included
+	std::vector<candidate> found(1);
+	for (uint32_t v = source; v != goal; v = graph.target(bwd.parent(v)))
+		found[0].edges.push_back(bwd.parent(v));
+	found[0].cost = bwd.cost(source);
+	found[0].deviation = 0;
+
+	std::priority_queue<candidate, std::vector<candidate>, std::greater<candidate>> pending;
+	std::set<std::vector<uint32_t>> seen{ found[0].edges };
+
+	std::vector<uint32_t> banned;
+	std::vector<uint32_t> spurEdges;
+
+	auto publish = [&](candidate const& route) {
+		paths::searchResult result;
+		graph.toLegs(route.edges, result.path);
+		result.cost = route.cost;
+		result.expanded = expanded;
+		result.found = true;
+		routes.push_back(std::move(result));
+	};
+	publish(found[0]);
+
+	while (routes.size() < count)
+	{
+		candidate const& last = found.back();
+
+		double rootCost = 0.0;
+		for (size_t i = 0; i < last.deviation; ++i)
+			rootCost += policy.cost(graph, last.edges[i]);
+
+		for (size_t i = last.deviation; i < last.edges.size(); ++i)
+		{
+			uint32_t const spur = graph.source(last.edges[i]);
+
+			// Routes sharing this root already left it through these connections
+			banned.clear();
+			for (auto const& route : found)
+			{
+				if (route.edges.size() > i && std::equal(last.edges.begin(), last.edges.begin() + i, route.edges.begin()))
+					banned.push_back(route.edges[i]);
 			}
 
-			dest.heuristic = mul * 1.6 * std::stod(PQgetvalue(res, 0, 0));
+			/*
+
+			Spur search, A* with the exact backward costs: the root places are closed before it starts
+
+			*/
+			fwd.reset(graph.nodeCount());
+			for (size_t r = 0; r < i; ++r)
+				fwd.close(graph.source(last.edges[r]));
+
+			fwd.relax(spur, 0.0, paths::SearchContext::NO_EDGE);
+			fwd.push(remaining(spur), spur);
+
+			while (!fwd.empty())
+			{
+				uint32_t u = fwd.pop().second;
+				fwd.close(u);
+				++expanded;
+
+				if (u == goal)
+					break;
+
+				for (uint32_t j = layer.outBegin(u); j < layer.outEnd(u); ++j)
+				{
+					uint32_t edge = layer.outEdge(j);
+					uint32_t v = graph.target(edge);
+
+					if (fwd.closed(v))
+						continue;
+					if (u == spur && std::find(banned.begin(), banned.end(), edge) != banned.end())
+						continue;
+
+					double g = fwd.cost(u) + policy.cost(graph, edge);
+					if (g < fwd.cost(v))
+					{
+						fwd.relax(v, g, edge);
+						fwd.push(g + remaining(v), v);
+					}
+				}
+			}
 
-			if (reached.find(dest.to) == reached.end())
+			if (fwd.closed(goal))
 			{
-				dest.distance += explored.top().distance;
-				queue.push(dest);
+				spurEdges.clear();
+				for (uint32_t v = goal; v != spur; v = graph.source(fwd.parent(v)))
+					spurEdges.push_back(fwd.parent(v));
+
+				candidate next{ std::vector<uint32_t>(last.edges.begin(), last.edges.begin() + i), rootCost + fwd.cost(goal), i };
+				next.edges.insert(next.edges.end(), spurEdges.rbegin(), spurEdges.rend());
+
+				if (seen.insert(next.edges).second)
+					pending.push(std::move(next));
 			}
+
+			rootCost += policy.cost(graph, last.edges[i]);
 		}
 
-		reached.insert(explored.top().to);
+		if (pending.empty())
+			break;
+
+		found.push_back(pending.top());
+		pending.pop();
+		publish(found.back());
 	}
 
-	std::vector<paths::destination> path;
+	return routes;
+}
 
-	// Reconstruct
-	if (explored.empty()) {
-		std::cerr << "A* Failed to explore any node!" << std::endl;
-		querybuilder.str(std::string());
-		destinations.clear();
-		PQclear(res);
-		return;
-	}
+/**
+ * Bidirectional A*: a forward search from the source over outgoing connections and a backward search
+ * from the goal over incoming ones, always expanding the smaller frontier.
+ *
+ * Both searches use the average potential pf(v) = (h(v, goal) - h(source, v)) / 2, with pb = -pf,
+ * which keeps reduced edge costs non-negative in both directions. Because of that the search can stop
+ * as soon as topF + topB >= mu, mu being the best source-goal path seen where the frontiers touch.
+ * The heuristic has to be a lower bound for this, which every cost policy guarantees.
+ */
+paths::searchResult Pathfinder::searchBidirectional(uint32_t source, uint32_t goal, short special_case, paths::VehicleLayer const& layer,
+	paths::SearchContext& fwd, paths::SearchContext& bwd) const
+{
+	return paths::withPolicy(special_case, [&](auto const& policy) { return bidirectional<paths::LandmarkBound>(source, goal, policy, layer, fwd, bwd); });
+}
 
-	path.emplace_back(explored.top());
+template<class Bound, class Policy>
+paths::searchResult Pathfinder::bidirectional(uint32_t source, uint32_t goal, Policy const& policy, paths::VehicleLayer const& layer,
+	paths::SearchContext& fwd, paths::SearchContext& bwd) const
+{
+	constexpr uint32_t NO_NODE = paths::GraphSnapshot::NO_NODE;
+	constexpr double INF = paths::SearchContext::INF;
 
-	if (path.back().to != _strtoi64(placecode_to.c_str(), nullptr, 10)) {
-		std::cerr << "For some reason A* did not return a path with our beginning as the first node\n something went horribly wrong, terminating." << std::endl;
-		querybuilder.str(std::string());
-		while (!explored.empty()) explored.pop();
-		destinations.clear();
-		reached.clear();
-		PQclear(res);
-		return;
-	}
+	paths::searchResult result;
+	Bound const bound(graph, source, goal);
 
-	for (; !explored.empty(); explored.pop()) {
-		paths::destination curr_destination = explored.top();
+	fwd.reset(graph.nodeCount());
+	bwd.reset(graph.nodeCount());
 
-		if (curr_destination.to == path.back().from) {
-			path.emplace_back(curr_destination);
-		}
-	}
+	// fwd.parent(v) is the edge used to reach v, bwd.parent(v) the edge used to leave v towards the goal
+	auto potential = [&](uint32_t v) { return 0.5 * (policy.heuristic(bound.toGoal(v)) - policy.heuristic(bound.fromSource(v))); };
 
-	if (path.back().from != _strtoi64(placecode_from.c_str(), nullptr, 10)) {
-		std::cerr << "For some reason after retrieveing it from A*, our path did not begin with the first node\n something went horribly wrong, terminating." << std::endl;
-		querybuilder.str(std::string());
-		destinations.clear();
-		reached.clear();
-		PQclear(res);
-		return;
-	}
+	fwd.relax(source, 0.0, paths::SearchContext::NO_EDGE);
+	bwd.relax(goal, 0.0, paths::SearchContext::NO_EDGE);
+	fwd.push(potential(source), source);
+	bwd.push(-potential(goal), goal);
 
-	path.pop_back();
-	std::reverse(path.begin(), path.end());
+	double mu = (source == goal) ? 0.0 : INF;
+	uint32_t meet = (source == goal) ? source : NO_NODE;
 
-	size_t i = 0;
+	while (!fwd.empty() && !bwd.empty())
+	{
+		if (fwd.top().first + bwd.top().first >= mu)
+			break;
 
+		bool const forward = fwd.size() <= bwd.size();
+		paths::SearchContext& self = forward ? fwd : bwd;
+		paths::SearchContext& other = forward ? bwd : fwd;
 
-	std::cout << " Chosen path is: " << std::endl;
-	for (auto const& node : path)
+		uint32_t u = self.pop().second;
+
+		if (self.closed(u)) continue;
+		self.close(u);
+		++result.expanded;
+
+		uint32_t const begin = forward ? layer.outBegin(u) : layer.inBegin(u);
+		uint32_t const end = forward ? layer.outEnd(u) : layer.inEnd(u);
+
+		for (uint32_t i = begin; i < end; ++i)
 		{
-			std::cout << " (" << i++ << "): " << node.from << " " << node.to << " " << node.distance << std::endl;
-		}
+			uint32_t edge = forward ? layer.outEdge(i) : layer.inEdge(i);
+			uint32_t v = forward ? graph.target(edge) : graph.source(edge);
+			if (self.closed(v)) continue;
 
-	std::string input;
-	std::cout << " Do you wish to select this path (y)?" << std::endl;
-	std::cin >> input;
+			double g = self.cost(u) + policy.cost(graph, edge);
+			if (g < self.cost(v))
+			{
+				self.relax(v, g, edge);
+				self.push(forward ? g + potential(v) : g - potential(v), v);
+			}
 
-	if (input != "y") {
-		querybuilder.str(std::string());
-		destinations.clear();
-		reached.clear();
-		PQclear(res);
-		return;
+			if (double through = self.cost(v) + other.cost(v); through < mu)
+			{
+				mu = through;
+				meet = v;
+			}
+		}
 	}
 
-	//We inject this route!
-	querybuilder.str(std::string());
+	if (meet == NO_NODE)
+	{
+		std::cerr << "Bidirectional A* could not connect the two Centers of Interest!" << std::endl;
+		return result;
+	}
+
+	// Stitch: source -> meet from the forward tree, then meet -> goal from the backward tree
+	auto const reconstructing = std::chrono::steady_clock::now();
+	std::vector<uint32_t> legs;
+	for (uint32_t v = meet; v != source; v = graph.source(fwd.parent(v)))
+		legs.push_back(fwd.parent(v));
+	std::reverse(legs.begin(), legs.end());
+
+	for (uint32_t v = meet; v != goal; v = graph.target(bwd.parent(v)))
+		legs.push_back(bwd.parent(v));
+
+	graph.toLegs(legs, result.path);
+	result.reconstructionMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - reconstructing).count();
+
+	result.cost = mu;
+	result.found = true;
+	return result;
+}
+
+/**
+ * Builds the "inject_route" call storing a path for a client.
+ */
+std::string Pathfinder::injectQuery(std::vector<paths::destination> const& path, int64_t from_code, int64_t to_code, int64_t client) const
+{
+	std::stringstream querybuilder;
 	querybuilder << "SELECT * FROM \"inject_route\"(" << from_code << ", " << to_code << ", "<<  client <<", ";
 
 	std::stringstream arr1;
@@ -287,29 +1724,60 @@ void Pathfinder::pathfind(int64_t from_code, int64_t to_code, int64_t client, sh
 	arr3_str.erase(arr3_str.size() - 4, 2);
 
 	querybuilder << arr1_str << ", " << arr2_str << ", " << arr3_str << ")";
+	return querybuilder.str();
+}
+
+void Pathfinder::offerPath(std::vector<paths::destination> const& path, int64_t from_code, int64_t to_code, int64_t client)
+{
+	//Utility printer
+	CLprinter printer;
+	PGresult* res = nullptr;
+	std::stringstream querybuilder;
+
+	size_t i = 0;
+
+
+	std::cout << " Chosen path is: " << std::endl;
+	for (auto const& node : path)
+		{
+			std::cout << " (" << i++ << "): " << node.from << " " << node.to << " " << node.distance << std::endl;
+		}
+
+	std::string input;
+	std::cout << " Do you wish to select this path (y)?" << std::endl;
+	std::cin >> input;
+
+	if (input != "y") {
+		return;
+	}
+
+	//We inject this route!
+	auto const injecting = std::chrono::steady_clock::now();
+	querybuilder.str(std::string());
+	querybuilder << injectQuery(path, from_code, to_code, client);
 
-	
 	int64_t ID = 0;
-	if (query::atomicQuery(querybuilder.str().c_str(), res, conn) && PQntuples(res) > 0)
+	if (query::executeQuery(querybuilder.str().c_str(), res, conn) && PQntuples(res) > 0)
 	{
-		ID = _strtoi64(PQgetvalue(res, 0, 0), nullptr, 10);
+		ID = query::resultView(res).integer(0, 0);
 	}
 	else
 	{
 		std::cerr << "\n An error has occurred on the Database while injecting the route, check the stack-trace for more info." << std::endl;
 		querybuilder.str(std::string());
-		destinations.clear();
-		reached.clear();
 		PQclear(res);
+		res = nullptr;
+		lastStats.time(paths::SearchPhase::INJECTION) += msSince(injecting);
 		return;
 	}
 	
 	PQclear(res);
 	querybuilder.str(std::string());
 
-	querybuilder << "SELECT * FROM public.\"Contains\" WHERE \"Contains\".\"RouteCode\" = " << ID << "ORDER BY \"Contains\".\"Order\"";
+	bool const fetched = prepared.execute(query::statements::ROUTE_CONTAINS, { std::to_string(ID) }, res) && PQntuples(res) > 0;
+	lastStats.time(paths::SearchPhase::INJECTION) += msSince(injecting);
 
-	if (query::atomicQuery(querybuilder.str().c_str(), res, conn) && PQntuples(res) > 0)
+	if (fetched)
 	{
 		std::cout << "\n A summary of the route (in terms of places):" << std::endl;
 		printer.printTable(res);
@@ -320,8 +1788,7 @@ void Pathfinder::pathfind(int64_t from_code, int64_t to_code, int64_t client, sh
 	}
 
 	PQclear(res);
+	res = nullptr;
 
 	querybuilder.str(std::string());
-	reached.clear();
-	destinations.clear();
 }
@@ -1,49 +1,311 @@
 #pragma once
 #include "libpq-fe.h"
 #include "cstdint"
+#include "..\DButils\PreparedStatements.h"
+#include "graph/PathTypes.h"
+#include "graph/GraphSnapshot.h"
+#include "graph/ContractionHierarchy.h"
+#include "graph/VehicleLayer.h"
+#include "graph/RouteCache.h"
+#include "graph/SearchContext.h"
+#include "graph/CostPolicies.h"
+#include "graph/DistanceBounds.h"
+#include "graph/ConnectionListener.h"
+#include "graph/IncrementalSearch.h"
+#include "graph/DistanceMatrix.h"
+#include "graph/Reachability.h"
+#include "graph/SearchStats.h"
+#include <array>
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 
 
-namespace paths
+class Pathfinder
 {
-	enum VehicleType : char
-	{
-		PLANE = 1,
-		SHIP = 2,
-		CAR = 4
-	};
+public:
 
-	struct pathOptions
-	{
+	/**
+	 * A Pathfinder only keeps the connection, every query result stays local to the call using it.
+	 * Searches run on per-search contexts, so separate instances on separate connections can be used
+	 * from separate threads at the same time.
+	 */
+	explicit Pathfinder(PGconn* conn, std::string snapshot_path=DEFAULT_SNAPSHOT) : conn(conn), prepared(conn), snapshotPath(std::move(snapshot_path)) {};
 
-		char allowedVehicles;
+	/**
+	 * Writes the graph back to the snapshot file if changes were applied to it since it was last written.
+	 */
+	~Pathfinder();
 
-	};
+	// Snapshot file of the connection graph, read at startup instead of "Connection" while it is current
+	static constexpr const char* DEFAULT_SNAPSHOT = "connection_graph.snapshot";
 
-	struct destination
-	{
-		VehicleType vehicle;
-		int64_t from;
-		int64_t to;
-		double distance;
-		double fee;
-		double heuristic;
-
-	public:
-		inline destination(paths::VehicleType const vehicleType, int64_t const from_code, int64_t const to_code, double const distance_val, double const fee, double const heuristic) 
-			: vehicle(vehicleType), from(from_code), to(to_code), distance(distance_val), fee(fee), heuristic(heuristic) {}
-		destination(destination const& other) = default;
-	};
-}
+	/**
+	 * Finds a route between two Centers of Interest, shows it and injects it on confirmation.
+	 * Every mode only travels on the vehicles in options.allowedVehicles, the Pareto mode lists the whole
+	 * front of (distance, fee, vehicle changes) and lets the user pick a route, the anytime mode shows a
+	 * rough route at once and keeps improving it until it is optimal or a key is pressed, the alternatives
+	 * mode lists the options.alternatives cheapest loopless routes and lets the user pick one.
+	 */
+	void pathfind(int64_t from_code, int64_t to_code, int64_t client, short special_case=0, 
+		paths::SearchMode mode=paths::SearchMode::UNIDIRECTIONAL, paths::pathOptions const& options={});
 
-class Pathfinder
-{
-public:
+	/**
+	 * Plans a whole batch of routes without prompting: one query resolves every Center of Interest, the
+	 * connection graph is loaded once and shared read-only, and the searches (bidirectional A*) run on
+	 * a pool of worker threads. Results come back in the same order as the requests.
+	 *
+	 * \param requests    Routes to plan.
+	 * \param inject      If true, every route found is stored through "inject_route", group_size routes per transaction.
+	 * \param group_size  Routes per injection transaction, a failing route rolls back its whole group.
+	 * \return            One result per request, unresolved or unreachable pairs are left with found == false.
+	 */
+	std::vector<paths::searchResult> pathfindBatch(std::vector<paths::routeRequest> const& requests, bool inject=false, size_t group_size=64);
+
+	/**
+	 * Reads batch requests from a text file, one "from,to,client[,special_case[,allowed_vehicles]]" line each.
+	 * Empty lines and lines starting with '#' are skipped.
+	 *
+	 * \return  False if the file could not be opened or a line could not be parsed.
+	 */
+	static bool readBatch(std::string const& file, std::vector<paths::routeRequest>& requests);
+
+	/**
+	 * Finds the stored routes hit by the connection changes received since the last call (a leg whose connection
+	 * was removed or changed distance) and repairs them: every route keeps its own incremental search (LPA*)
+	 * between its ends on the layer of the vehicles its legs travel on, fed with every change, so a repair only
+	 * expands the places the changes touched and never switches to a vehicle the route did not use.
+	 * Routes with non-historical shipments keep their search even when untouched, the others get one once hit.
+	 * Nothing is written to the DB.
+	 *
+	 * Changes are only known while the graph is kept up to date in place: after a full reload (a TRUNCATE,
+	 * a lost notification) the searches start over and only routes with a vanished leg are reported.
+	 *
+	 * \return  One entry per affected route, in route order.
+	 */
+	std::vector<paths::routeRepair> replanRoutes();
+
+	/**
+	 * Computes the shortest distance (and the fee of that route) between every pair of Centers of Interest of
+	 * a company, or of the whole DB, with a many-to-many search over the Contraction Hierarchy of the allowed
+	 * vehicles (see DistanceMatrix). Rows and columns follow the Center IDs in ascending order.
+	 *
+	 * \param company  "Company" ID, 0 for every Center of Interest.
+	 * \return         False if the graph or the Centers could not be read.
+	 */
+	bool distanceMatrix(int64_t company, paths::pathOptions const& options, paths::DistanceMatrix& matrix);
+
+	/**
+	 * Lists every place a Center of Interest can reach on the allowed vehicles within a budget of travelled
+	 * distance or of total fee, in a single bounded search (see paths::Reachability), nearest first.
+	 *
+	 * \return  False if the Center or the graph could not be read.
+	 */
+	bool reachable(int64_t coi_code, paths::ReachMetric metric, double budget, paths::pathOptions const& options,
+		std::vector<paths::reachablePlace>& places);
 
-	Pathfinder(PGconn*& conn, PGresult*& res) : conn(conn), res(res) {};
-	void pathfind(int64_t from_code, int64_t to_code, int64_t client, short special_case=0);
+	/**
+	 * Replaces the graph with one built from rows rather than read from the DB, for searchPlaces() to run on without
+	 * a connection. Such a graph has no version: the route cache stays off and no snapshot file gets written.
+	 */
+	void assignGraph(std::vector<paths::placeRow> const& place_rows, std::vector<paths::connectionRow> const& connection_rows);
+
+	/**
+	 * Runs one search between two Places of the current graph and returns it, with no Center of Interest to resolve,
+	 * no reload, no route cache and no prompt. The anytime mode refines its route until it is optimal and the
+	 * alternatives mode returns its first route; the hierarchy and the Pareto mode take no special option and
+	 * come back with found == false.
+	 */
+	paths::searchResult searchPlaces(int64_t from_place, int64_t to_place, short special_case, paths::SearchMode mode,
+		char allowed_vehicles=paths::ALL_VEHICLES);
+
+	/**
+	 * Runs every search mode on the same pair of Centers of Interest and prints nodes expanded and
+	 * wall time for each, plus preprocessing cost and memory of the Contraction Hierarchy and the gain of the
+	 * landmark heuristic over the straight line; nothing is injected.
+	 */
+	void benchmark(int64_t from_code, int64_t to_code, short special_case=0);
+
+	/**
+	 * Drops the in-memory copy of "Connection" and everything derived from it, the next search will load it again.
+	 * Searches keep the copy current on their own: row changes sent by the connection_delta trigger are applied
+	 * in place, and only a "ConnectionVersion" no change accounts for (a TRUNCATE, a lost notification) forces a reload.
+	 */
+	void invalidateGraph() 
+	{ 
+		graph.clear(); 
+		dropDerived();
+		cache.clear();
+
+		// Node indices do not survive a reload
+		repairs.clear();
+		changedConnections.clear();
+	}
+
+	paths::RouteCache const& getCache() const { return cache; }
+	size_t getFullLoads() const { return fullLoads; }
+	size_t getSnapshotLoads() const { return snapshotLoads; }
+	size_t getChangesApplied() const { return changesApplied; }
+
+	/**
+	 * Counters and per-phase timings of the last pathfind() call, the time spent waiting for the user is left out.
+	 */
+	paths::searchStats const& getLastStats() const { return lastStats; }
 
 private:
+	bool resolvePlace(int64_t coi_code, int64_t& place_code, const char* which);
+
+	/**
+	 * Resolves both Centers of Interest and brings the graph up to date, timing both phases into stats if given.
+	 */
+	bool prepare(int64_t from_code, int64_t to_code, uint32_t& source, uint32_t& goal, paths::searchStats* stats=nullptr);
+	bool readGraphVersion(int64_t& version);
+	bool loadGraph();
+
+	/**
+	 * Applies the changes of "Connection" received since the last search, dropping what was derived from the old graph.
+	 *
+	 * \return  False if the changes could not be applied and the graph has to be loaded again.
+	 */
+	bool applyDeltas();
+
+	/**
+	 * Drops the vehicle layers and hierarchies built over the current graph.
+	 */
+	void dropDerived()
+	{
+		for (auto& layer : layers) layer.clear();
+		for (auto& hierarchy : hierarchies) hierarchy.clear();
+	}
+
+	/**
+	 * The body of pathfind(), which wraps it to count the round trips it makes.
+	 */
+	void findRoute(int64_t from_code, int64_t to_code, int64_t client, short special_case, paths::SearchMode mode, paths::pathOptions const& options);
+
+	/**
+	 * Adds the frontier counters of a context that just ran a search to lastStats.
+	 */
+	void countFrontier(paths::SearchContext const& ctx);
+
+	paths::routeKey keyOf(uint32_t source, uint32_t goal, short special_case, paths::SearchMode mode, char allowed_vehicles) const;
+
+	/*
+
+	The special_case overloads pick the cost policy once and forward to the searches instantiated for it,
+	which take their heuristic from a paths::LandmarkBound (Bound, see DistanceBounds.h)
+
+	*/
+	paths::searchResult searchUnidirectional(uint32_t source, uint32_t goal, short special_case, paths::VehicleLayer const& layer, paths::SearchContext& ctx) const;
+	paths::searchResult searchBidirectional(uint32_t source, uint32_t goal, short special_case, paths::VehicleLayer const& layer,
+		paths::SearchContext& fwd, paths::SearchContext& bwd) const;
+
+	template<class Bound, class Policy>
+	paths::searchResult unidirectional(uint32_t source, uint32_t goal, Policy const& policy, paths::VehicleLayer const& layer, paths::SearchContext& ctx) const;
+	template<class Bound, class Policy>
+	paths::searchResult bidirectional(uint32_t source, uint32_t goal, Policy const& policy, paths::VehicleLayer const& layer,
+		paths::SearchContext& fwd, paths::SearchContext& bwd) const;
+
+	/**
+	 * Anytime weighted A* (ARA*): a search with a heavily inflated heuristic finds a route fast, then the
+	 * weight is lowered step by step and each new search starts from everything the previous ones learned
+	 * (costs, parents and frontier), only expanding again the places whose cost improved.
+	 *
+	 * \param improved  Called with every better route and a bound on its cost over the optimum (1 once it
+	 *                  is optimal), returning false stops the refinement.
+	 * \return          The last route found.
+	 */
+	paths::searchResult searchAnytime(uint32_t source, uint32_t goal, short special_case, paths::VehicleLayer const& layer,
+		paths::SearchContext& ctx, std::function<bool(paths::searchResult const&, double)> const& improved) const;
+
+	template<class Bound, class Policy>
+	paths::searchResult anytime(uint32_t source, uint32_t goal, Policy const& policy, paths::VehicleLayer const& layer,
+		paths::SearchContext& ctx, std::function<bool(paths::searchResult const&, double)> const& improved) const;
+
+	std::vector<paths::paretoRoute> searchPareto(uint32_t source, uint32_t goal, paths::VehicleLayer const& layer, size_t& expanded);
+
+	/**
+	 * Yen's k shortest loopless routes under a special option. One backward search from the goal, run until it
+	 * settles the source, gives the exact cost left from every place closer than it: it yields the first route
+	 * directly and is the heuristic of every spur search (landmarks beyond it), which then hardly expands
+	 * anything off the routes. A spur search runs with the places of its root path closed and the next connection
+	 * of every route already found with that root banned, and only from the place a route deviated from its
+	 * parent onwards (Lawler), the spurs before it were already tried.
+	 *
+	 * \return  Up to count routes by increasing cost, expanded of each holds the places expanded until it was found.
+	 */
+	std::vector<paths::searchResult> searchAlternatives(uint32_t source, uint32_t goal, size_t count, short special_case,
+		paths::VehicleLayer const& layer, paths::SearchContext& fwd, paths::SearchContext& bwd) const;
+
+	template<class Policy>
+	std::vector<paths::searchResult> alternatives(uint32_t source, uint32_t goal, size_t count, Policy const& policy,
+		paths::VehicleLayer const& layer, paths::SearchContext& fwd, paths::SearchContext& bwd) const;
+
+	/**
+	 * Lists a Pareto front and asks which route to offer, returns front.size() if none was picked.
+	 */
+	size_t chooseRoute(std::vector<paths::paretoRoute> const& front);
+
+	/**
+	 * Lists alternative routes with the distance travelled on each vehicle and asks which one to offer,
+	 * returns routes.size() if none was picked.
+	 */
+	size_t chooseAlternative(std::vector<paths::searchResult> const& routes);
+
+	/**
+	 * Asks for the index of one of count listed routes, count if the answer is not one.
+	 */
+	size_t askRoute(size_t count);
+
+	paths::ContractionHierarchy const& hierarchyFor(char allowed_vehicles);
+
+	/**
+	 * The layer of the current graph for a vehicle mask, built on first use. Not thread-safe: batch
+	 * searches get their layers built before the workers start.
+	 */
+	paths::VehicleLayer const& layerFor(char allowed_vehicles);
+
+	std::string injectQuery(std::vector<paths::destination> const& path, int64_t from_code, int64_t to_code, int64_t client) const;
+	void offerPath(std::vector<paths::destination> const& path, int64_t from_code, int64_t to_code, int64_t client);
+
+	// Heuristic inflation the unidirectional mode used before landmarks, the benchmark still compares against it
+	static constexpr double COMPARISON_WEIGHT = 1.6;
+
+	// First heuristic weight of the anytime mode, its excess over 1 halves after every pass
+	static constexpr double ANYTIME_START_WEIGHT = 3.0;
+
 	PGconn* conn;
-	PGresult* res;
+	query::preparedStatements prepared;
+	paths::GraphSnapshot graph;
+
+	// Contexts of the interactive searches, batch workers bring their own
+	paths::SearchContext forwardSpace;
+	paths::SearchContext backwardSpace;
+
+	// One layer and one hierarchy per combination of paths::VehicleType bits, built on first use
+	std::array<paths::VehicleLayer, paths::ALL_VEHICLES + 1> layers;
+	std::array<paths::ContractionHierarchy, paths::ALL_VEHICLES + 1> hierarchies;
+	paths::ContractionHierarchy::workspace chSpace;
+	paths::Reachability reachability;
+
+	paths::RouteCache cache;
+	paths::ConnectionListener listener;
+	int64_t graphVersion = 0;
+	bool versioned = true;	// false once "ConnectionVersion" turned out to be missing, the cache is never used then
+	size_t fullLoads = 0;
+	size_t changesApplied = 0;
+
+	// Distance of every (from, to, vehicle) connection changed since the last replan before its first change (INF if it
+	// did not exist), and the incremental search of every route replanRoutes() keeps, by "Route" ID
+	std::map<std::tuple<uint32_t, uint32_t, paths::VehicleType>, double> changedConnections;
+	std::unordered_map<int64_t, paths::IncrementalSearch> repairs;
+
+	std::string snapshotPath;	// empty to never read or write a snapshot file
+	size_t snapshotLoads = 0;
+	bool snapshotStale = false;	// changes were applied that the file does not have
 
+	paths::searchStats lastStats;
 };
@@ -0,0 +1,255 @@
+#include "PathfinderCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Pathfinder.h"
+#include "..\DButils\queries.h"
+#include "..\DButils\ResultView.h"
+
+
+namespace
+{
+	void usage()
+	{
+		std::cerr << "Usage:\n"
+			<< "  DBapplication --selfcheck [--threads <n>] [--pairs <n>] [--rounds <n>]" << std::endl;
+	}
+
+	double msSince(std::chrono::steady_clock::time_point from)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+	}
+
+	/**
+	 * Same reachability and the same legs, compared exactly: both runs search the same graph with the same code.
+	 */
+	bool sameRoute(paths::searchResult const& a, paths::searchResult const& b)
+	{
+		if (a.found != b.found || a.path.size() != b.path.size())
+			return false;
+
+		for (size_t i = 0; i < a.path.size(); ++i)
+		{
+			auto const& x = a.path[i];
+			auto const& y = b.path[i];
+			if (x.from != y.from || x.to != y.to || x.vehicle != y.vehicle || x.distance != y.distance || x.fee != y.fee)
+				return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Every special option on a three place line whose two stretches each have a ship, a plane and a car connection:
+	 * the ship is the shortest, the plane dearer and the car longer but free, so each option but "Shortest" and
+	 * "Discourage planes" has to leave the shortest connection for a longer one. Every mode taking a special option
+	 * must travel both stretches on the vehicle expected and agree on the cost. Runs on its own graph, not the DB one.
+	 */
+	bool checkPolicies()
+	{
+		std::vector<paths::placeRow> const places = { { 1, 0.0, 0.0 }, { 2, 90.0, 0.0 }, { 3, 180.0, 0.0 } };
+		std::vector<paths::connectionRow> connections;
+		for (int64_t from = 1; from < 3; ++from)
+		{
+			connections.push_back({ from, from + 1, paths::SHIP, 1.0, 90.0 });
+			connections.push_back({ from, from + 1, paths::PLANE, 5.0, 100.0 });
+			connections.push_back({ from, from + 1, paths::CAR, 0.0, 120.0 });
+		}
+
+		// By special option: Shortest, Prefer cars, Discourage planes, Discourage ships, Less costly, Balanced
+		paths::VehicleType const expected[paths::POLICY_COUNT] = { paths::SHIP, paths::CAR, paths::SHIP, paths::PLANE, paths::CAR, paths::CAR };
+		paths::SearchMode const modes[] = { paths::SearchMode::UNIDIRECTIONAL, paths::SearchMode::BIDIRECTIONAL,
+			paths::SearchMode::ANYTIME, paths::SearchMode::ALTERNATIVES };
+
+		Pathfinder pather(nullptr, "");
+		pather.assignGraph(places, connections);
+
+		size_t wrong = 0;
+		for (short policy = 0; policy < paths::POLICY_COUNT; ++policy)
+		{
+			double cost = -1.0;
+			for (auto const mode : modes)
+			{
+				auto const route = pather.searchPlaces(1, 3, policy, mode);
+
+				bool right = route.found && route.path.size() == 2 && (cost < 0.0 || route.cost == cost);
+				for (auto const& leg : route.path)
+					right = right && leg.vehicle == expected[policy];
+
+				if (!right)
+				{
+					std::cerr << " Special option " << policy << ", mode " << static_cast<int>(mode) << ": not the route over the "
+						<< (expected[policy] == paths::CAR ? "car" : (expected[policy] == paths::PLANE ? "plane" : "ship")) << " connections!" << std::endl;
+					++wrong;
+				}
+				else if (cost < 0.0)
+					cost = route.cost;
+			}
+		}
+
+		std::cout << " Cost policies: " << paths::POLICY_COUNT << " special options x " << std::size(modes) << " modes on parallel connections, "
+			<< (wrong == 0 ? "every route is the cheapest one." : "MISMATCH.") << std::endl;
+		return wrong == 0;
+	}
+
+	/**
+	 * Picks count pairs of distinct Centers of Interest, always the same ones for the same DB.
+	 */
+	bool readPairs(PGconn* conn, size_t count, std::vector<paths::routeRequest>& pairs)
+	{
+		PGresult* res = nullptr;
+		if (!query::executeQuery("SELECT \"ID\" FROM public.\"CenterOfInterest\" ORDER BY \"ID\";", res, conn, query::resultFormat::BINARY))
+		{
+			std::cerr << "Could not read the Centers of Interest!" << std::endl;
+			PQclear(res);
+			return false;
+		}
+
+		auto const column = query::resultView(res).get<int64_t>(0);
+		std::vector<int64_t> centers(column.begin(), column.end());
+		PQclear(res);
+
+		if (centers.size() < 2)
+		{
+			std::cerr << "At least two Centers of Interest are needed, " << centers.size() << " found." << std::endl;
+			return false;
+		}
+
+		std::mt19937_64 random(42);
+		std::uniform_int_distribution<size_t> pick(0, centers.size() - 1);
+
+		while (pairs.size() < count)
+		{
+			size_t const from = pick(random);
+			size_t const to = pick(random);
+			if (from != to)
+				pairs.push_back({ centers[from], centers[to], 0, 0, paths::pathOptions{} });
+		}
+
+		return true;
+	}
+}
+
+int pathfinderCheck(int argc, char** argv, std::string const& conninfo)
+{
+	size_t threads = 8;
+	size_t pair_count = 200;
+	size_t rounds = 4;
+
+	if (argc % 2 != 0)
+	{
+		usage();
+		return 1;
+	}
+
+	for (int i = 0; i + 1 < argc; i += 2)
+	{
+		std::string const option = argv[i];
+		size_t const value = static_cast<size_t>(std::max<int64_t>(1, _strtoi64(argv[i + 1], nullptr, 10)));
+
+		if (option == "--threads") threads = value;
+		else if (option == "--pairs") pair_count = value;
+		else if (option == "--rounds") rounds = value;
+		else { usage(); return 1; }
+	}
+
+	bool const priced = checkPolicies();
+
+	PGconn* conn = query::connect(conninfo.c_str());
+	std::vector<paths::routeRequest> pairs;
+
+	if (!readPairs(conn, pair_count, pairs))
+	{
+		PQfinish(conn);
+		return 1;
+	}
+
+	/*
+
+	Reference: one request per batch, so a single worker runs every search
+
+	*/
+	auto start = std::chrono::steady_clock::now();
+	std::vector<paths::searchResult> expected;
+	expected.reserve(pairs.size());
+	{
+		Pathfinder serial(conn, "");
+		for (auto const& pair : pairs)
+			expected.push_back(serial.pathfindBatch({ pair }).front());
+	}
+	PQfinish(conn);
+
+	size_t const found = std::count_if(expected.begin(), expected.end(), [](paths::searchResult const& result) { return result.found; });
+	std::cout << " Serial: " << pairs.size() << " pairs, " << found << " routes found (" << msSince(start) << " ms)" << std::endl;
+
+	/*
+
+	Every thread its own instance and connection, searching every pair rounds times in its own order in a single
+	batch: the pairs repeat within the batch, so none is served from the route cache and the contexts get reused
+
+	*/
+	std::vector<PGconn*> connections;
+	for (size_t t = 0; t < threads; ++t)
+		connections.push_back(query::connect(conninfo.c_str()));
+
+	std::vector<size_t> mismatches(threads, 0);
+	std::vector<size_t> searched(threads, 0);
+
+	auto run = [&](size_t t) {
+		Pathfinder pather(connections[t], "");
+		std::mt19937_64 random(t + 1);
+
+		std::vector<size_t> order;
+		for (size_t round = 0; round < rounds; ++round)
+		{
+			std::vector<size_t> shuffled(pairs.size());
+			std::iota(shuffled.begin(), shuffled.end(), 0);
+			std::shuffle(shuffled.begin(), shuffled.end(), random);
+			order.insert(order.end(), shuffled.begin(), shuffled.end());
+		}
+
+		std::vector<paths::routeRequest> requests;
+		requests.reserve(order.size());
+		for (auto const pair : order)
+			requests.push_back(pairs[pair]);
+
+		auto results = pather.pathfindBatch(requests);
+		searched[t] = results.size();
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			if (!sameRoute(results[i], expected[order[i]]))
+				++mismatches[t];
+		}
+	};
+
+	start = std::chrono::steady_clock::now();
+	std::vector<std::thread> pool;
+	for (size_t t = 0; t < threads; ++t)
+		pool.emplace_back(run, t);
+	for (auto& thread : pool)
+		thread.join();
+	double const elapsed = msSince(start);
+
+	for (auto connection : connections)
+		PQfinish(connection);
+
+	size_t total_mismatches = 0;
+	for (size_t t = 0; t < threads; ++t)
+	{
+		total_mismatches += mismatches[t];
+		if (mismatches[t] != 0 || searched[t] != pairs.size() * rounds)
+			std::cerr << " Thread " << t << ": " << mismatches[t] << " of " << searched[t] << " routes differ from the serial ones!" << std::endl;
+	}
+
+	bool const passed = priced && total_mismatches == 0 && std::all_of(searched.begin(), searched.end(), [&](size_t n) { return n == pairs.size() * rounds; });
+	std::cout << " Concurrent: " << threads << " threads x " << pairs.size() * rounds << " searches (" << elapsed << " ms), "
+		<< (passed ? "every route matches the serial run." : "MISMATCH.") << std::endl;
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+
+
+/**
+ * Command line self-check of the pathfinder's reentrancy, run as "DBapplication --selfcheck [options]":
+ *
+ *     --threads <n>   Pathfinder instances run at once, each on its own thread and connection (default 8).
+ *     --pairs <n>     Pairs of Centers of Interest searched, taken from the DB (default 200).
+ *     --rounds <n>    Times every thread searches the whole set of pairs, in its own order (default 4).
+ *
+ * The pairs are first searched one at a time by a single instance, then by all the threads at the same time,
+ * every thread with its own connection and search contexts (and its batch workers with theirs); each concurrent
+ * route has to match the serial one leg by leg. Before that, every special option is run on a small graph of its
+ * own where the cheapest connection is not the shortest one. Nothing is injected and no snapshot file is read or written.
+ *
+ * \param conninfo  Connection string, one connection is opened per thread plus one for the serial run.
+ * \return          Exit code, 0 if every route matched.
+ */
+int pathfinderCheck(int argc, char** argv, std::string const& conninfo);
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace paths
+{
+	/**
+	 * Read-only array that either owns its elements or borrows them from memory kept alive by someone else
+	 * (a mapped snapshot file), so the searches read the graph the same way wherever it came from.
+	 */
+	template<class T>
+	class Column
+	{
+	public:
+		Column() = default;
+		Column(Column&&) = default;
+		Column& operator=(Column&&) = default;
+
+		// A copy of a borrowed column would outlive nothing, a copy of an owned one would point into the source
+		Column(Column const&) = delete;
+		Column& operator=(Column const&) = delete;
+
+		T const& operator[](size_t i) const { return view[i]; }
+		T const* data() const { return view; }
+		T const* begin() const { return view; }
+		T const* end() const { return view + count; }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		bool isBorrowed() const { return borrowed; }
+
+		void assign(std::vector<T>&& values)
+		{
+			owned = std::move(values);
+			view = owned.data();
+			count = owned.size();
+			borrowed = false;
+		}
+
+		void borrow(T const* values, size_t n)
+		{
+			std::vector<T>().swap(owned);
+			view = values;
+			count = n;
+			borrowed = true;
+		}
+
+		/**
+		 * Copies borrowed elements into storage of its own, so the memory they came from can go away.
+		 */
+		void own()
+		{
+			if (borrowed)
+				assign(std::vector<T>(begin(), end()));
+		}
+
+		void clear()
+		{
+			std::vector<T>().swap(owned);
+			view = nullptr;
+			count = 0;
+			borrowed = false;
+		}
+
+	private:
+		std::vector<T> owned;
+		T const* view = nullptr;
+		size_t count = 0;
+		bool borrowed = false;
+	};
+}
@@ -0,0 +1,83 @@
+#include "ConnectionListener.h"
+#include <cstring>
+#include <sstream>
+#include <string>
+#include "../../DButils/queries.h"
+
+
+namespace paths
+{
+	bool ConnectionListener::listen(PGconn* const& conn)
+	{
+		PGresult* res = nullptr;
+		std::string command = std::string("LISTEN ") + CHANNEL + ";";
+
+		listening = query::executeQuery(command.c_str(), res, conn);
+		PQclear(res);
+
+		if (!listening)
+			std::cerr << "Could not listen for changes of the Connection table, the pathfinder will reload it instead." << std::endl;
+
+		return listening;
+	}
+
+	bool ConnectionListener::poll(PGconn* const& conn, std::vector<edgeDelta>& deltas)
+	{
+		bool complete = PQconsumeInput(conn) != 0;
+
+		while (PGnotify* notify = PQnotifies(conn))
+		{
+			edgeDelta delta{};
+
+			if (std::strcmp(notify->relname, CHANNEL) == 0)
+			{
+				if (parse(notify->extra, delta))
+				{
+					deltas.push_back(delta);
+					++received;
+				}
+				else
+				{
+					std::cerr << "Unreadable change of the Connection table: \"" << notify->extra << "\"" << std::endl;
+					complete = false;
+				}
+			}
+
+			PQfreemem(notify);
+		}
+
+		return complete;
+	}
+
+	bool ConnectionListener::parse(const char* payload, edgeDelta& delta)
+	{
+		// version,op,PlaceA,PlaceB,AllowedVehicles[,fee,distance]
+		std::stringstream fields(payload);
+		std::string version, op, from, to, vehicle, fee, distance;
+
+		if (!(std::getline(fields, version, ',') && std::getline(fields, op, ',') && std::getline(fields, from, ',')
+			&& std::getline(fields, to, ',') && std::getline(fields, vehicle, ',')))
+			return false;
+
+		if (op != "I" && op != "D")
+			return false;
+
+		delta.version = _strtoi64(version.c_str(), nullptr, 10);
+		delta.removed = (op == "D");
+		delta.from = _strtoi64(from.c_str(), nullptr, 10);
+		delta.to = _strtoi64(to.c_str(), nullptr, 10);
+		delta.vehicle = toVehicle(vehicle);
+
+		if (delta.removed)
+			return true;
+
+		if (!(std::getline(fields, fee, ',') && std::getline(fields, distance, ',')))
+			return false;
+
+		// fee and distance are "real" columns: rounded through float like the binary full load, so a patched graph
+		// holds the same doubles as a freshly loaded one (GraphSnapshot::sameAs compares them bit for bit)
+		delta.fee = static_cast<float>(std::strtod(fee.c_str(), nullptr));
+		delta.distance = static_cast<float>(std::strtod(distance.c_str(), nullptr));
+		return true;
+	}
+}
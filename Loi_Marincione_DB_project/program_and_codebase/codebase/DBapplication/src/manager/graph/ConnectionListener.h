@@ -0,0 +1,45 @@
+#pragma once
+#include "libpq-fe.h"
+#include <cstdint>
+#include <vector>
+#include "GraphSnapshot.h"
+
+
+namespace paths
+{
+	/**
+	 * Receives the row changes of "Connection" that the connection_delta trigger sends through LISTEN/NOTIFY.
+	 *
+	 * Notifications are only collected by libpq while the connection talks to the server, so poll() never
+	 * waits: it picks up whatever arrived with the previous queries. Changes committed after listen() are
+	 * all delivered, in commit order, the snapshot loaded after subscribing misses none of them.
+	 */
+	class ConnectionListener
+	{
+	public:
+		static constexpr const char* CHANNEL = "connection_delta";
+
+		/**
+		 * Subscribes conn to the channel, the subscription lasts as long as the connection.
+		 *
+		 * \return  True if the LISTEN command succeeded.
+		 */
+		bool listen(PGconn* const& conn);
+
+		/**
+		 * Appends every change received so far to deltas, oldest first.
+		 *
+		 * \return  False if the connection broke or a payload could not be read, the changes are incomplete then.
+		 */
+		bool poll(PGconn* const& conn, std::vector<edgeDelta>& deltas);
+
+		bool isListening() const { return listening; }
+		size_t getReceived() const { return received; }
+
+	private:
+		static bool parse(const char* payload, edgeDelta& delta);
+
+		bool listening = false;
+		size_t received = 0;
+	};
+}
@@ -0,0 +1,423 @@
+#include "ContractionHierarchy.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <queue>
+
+
+namespace paths
+{
+	namespace
+	{
+		constexpr double INF = std::numeric_limits<double>::infinity();
+		constexpr uint32_t NO_ARC = UINT32_MAX;
+
+		// Witness searches give up after settling this many places, worst case we add a redundant shortcut.
+		// Estimating a priority only needs a rough shortcut count, so it gets a much smaller budget.
+		constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+		constexpr size_t SIMULATION_SETTLE_LIMIT = 50;
+
+		using entry = std::pair<double, uint32_t>;
+		using minheap = std::priority_queue<entry, std::vector<entry>, std::greater<entry>>;
+	}
+
+	void ContractionHierarchy::build(GraphSnapshot const& graph, char allowed_vehicles)
+	{
+		clear();
+		allowed = allowed_vehicles;
+
+		uint32_t const nNodes = static_cast<uint32_t>(graph.nodeCount());
+
+		// Arcs between places that are not contracted yet
+		std::vector<std::vector<uint32_t>> out(nNodes);
+		std::vector<std::vector<uint32_t>> in(nNodes);
+
+		for (uint32_t u = 0; u < nNodes; ++u)
+		{
+			uint32_t last_target = GraphSnapshot::NO_NODE;
+			for (uint32_t edge = graph.edgesBegin(u); edge < graph.edgesEnd(u); ++edge)
+			{
+				uint32_t v = graph.target(edge);
+				if (!(graph.vehicle(edge) & allowed) || v == last_target || v == u)
+					continue;
+
+				// Edges are sorted by (target, distance), the first usable one is the shortest
+				last_target = v;
+				out[u].push_back(static_cast<uint32_t>(arcs.size()));
+				in[v].push_back(static_cast<uint32_t>(arcs.size()));
+				arcs.push_back({ u, v, graph.distance(edge), graph.fee(edge), NO_ARC, NO_ARC, edge });
+			}
+		}
+
+		rank.assign(nNodes, GraphSnapshot::NO_NODE);
+		std::vector<uint32_t> deleted(nNodes, 0);
+		std::vector<std::vector<uint32_t>> upOf(nNodes);
+		std::vector<std::vector<uint32_t>> downOf(nNodes);
+		auto contracted = [&](uint32_t v) { return rank[v] != GraphSnapshot::NO_NODE; };
+
+		// Witness search scratch
+		std::vector<double> dist(nNodes, INF);
+		std::vector<uint32_t> touched;
+		std::vector<bool> wanted(nNodes, false);
+		std::vector<entry> heap;
+
+		// Shortest paths from 'from' that avoid 'avoid', until every wanted place is settled or the limits hit
+		auto witness = [&](uint32_t from, uint32_t avoid, double limit, size_t pending, size_t settle_limit) {
+			for (auto const v : touched) dist[v] = INF;
+			touched.clear();
+			heap.clear();
+
+			dist[from] = 0.0;
+			touched.push_back(from);
+			heap.emplace_back(0.0, from);
+
+			for (size_t settled = 0; !heap.empty() && pending > 0 && settled < settle_limit; ++settled)
+			{
+				std::pop_heap(heap.begin(), heap.end(), std::greater<entry>());
+				auto [d, u] = heap.back();
+				heap.pop_back();
+
+				if (d > dist[u]) continue;
+				if (d > limit) break;
+				if (wanted[u]) --pending;
+
+				for (auto const a : out[u])
+				{
+					uint32_t v = arcs[a].to;
+					if (v == avoid) continue;
+
+					double nd = d + arcs[a].weight;
+					if (nd < dist[v])
+					{
+						if (dist[v] == INF) touched.push_back(v);
+						dist[v] = nd;
+						heap.emplace_back(nd, v);
+						std::push_heap(heap.begin(), heap.end(), std::greater<entry>());
+					}
+				}
+			}
+		};
+
+		auto addShortcut = [&](uint32_t a, uint32_t b) {
+			uint32_t u = arcs[a].from;
+			uint32_t x = arcs[b].to;
+			double w = arcs[a].weight + arcs[b].weight;
+			double fee = arcs[a].fee + arcs[b].fee;
+			uint32_t id = static_cast<uint32_t>(arcs.size());
+
+			for (auto& existing : out[u])
+			{
+				if (arcs[existing].to != x) continue;
+				if (arcs[existing].weight <= w) return;
+
+				std::replace(in[x].begin(), in[x].end(), existing, id);
+				existing = id;
+				arcs.push_back({ u, x, w, fee, a, b, NO_ARC });
+				++shortcuts;
+				return;
+			}
+
+			out[u].push_back(id);
+			in[x].push_back(id);
+			arcs.push_back({ u, x, w, fee, a, b, NO_ARC });
+			++shortcuts;
+		};
+
+		// Contracts v, or only counts the shortcuts it would need (with cheaper witness searches) when apply is false
+		auto contract = [&](uint32_t v, bool apply) {
+			int added = 0;
+			double max_out = 0.0;
+
+			for (auto const b : out[v])
+			{
+				max_out = std::max(max_out, arcs[b].weight);
+				wanted[arcs[b].to] = true;
+			}
+
+			for (size_t i = 0; i < in[v].size(); ++i)
+			{
+				uint32_t a = in[v][i];
+				uint32_t u = arcs[a].from;
+
+				witness(u, v, arcs[a].weight + max_out, out[v].size(), apply ? WITNESS_SETTLE_LIMIT : SIMULATION_SETTLE_LIMIT);
+
+				for (size_t j = 0; j < out[v].size(); ++j)
+				{
+					uint32_t b = out[v][j];
+					uint32_t x = arcs[b].to;
+					if (x == u) continue;
+
+					if (dist[x] > arcs[a].weight + arcs[b].weight)
+					{
+						++added;
+						if (apply) addShortcut(a, b);
+					}
+				}
+			}
+
+			for (auto const b : out[v])
+				wanted[arcs[b].to] = false;
+
+			return added;
+		};
+
+		auto priority = [&](uint32_t v) {
+			int degree = static_cast<int>(in[v].size() + out[v].size());
+			// edge difference dominates, deleted neighbours spread the order out
+			return 2 * (contract(v, false) - degree) + static_cast<int>(deleted[v]);
+		};
+
+		using ordered = std::pair<int, uint32_t>;
+		std::priority_queue<ordered, std::vector<ordered>, std::greater<ordered>> order;
+		for (uint32_t v = 0; v < nNodes; ++v)
+			order.emplace(priority(v), v);
+
+		uint32_t level = 0;
+		while (!order.empty())
+		{
+			uint32_t v = order.top().second;
+			order.pop();
+
+			if (contracted(v)) continue;
+
+			// Lazy update: priorities drift as neighbours get contracted
+			int current = priority(v);
+			if (!order.empty() && current > order.top().first)
+			{
+				order.emplace(current, v);
+				continue;
+			}
+
+			contract(v, true);
+			rank[v] = level++;
+
+			// The live arcs of v are exactly its upward and downward arcs, detach them from the remaining graph
+			for (auto const a : out[v])
+			{
+				uint32_t x = arcs[a].to;
+				++deleted[x];
+				upOf[v].push_back(a);
+				in[x].erase(std::remove(in[x].begin(), in[x].end(), a), in[x].end());
+			}
+
+			for (auto const a : in[v])
+			{
+				uint32_t u = arcs[a].from;
+				++deleted[u];
+				downOf[v].push_back(a);
+				out[u].erase(std::remove(out[u].begin(), out[u].end(), a), out[u].end());
+			}
+
+			std::vector<uint32_t>().swap(out[v]);
+			std::vector<uint32_t>().swap(in[v]);
+		}
+
+		// Freeze the search graphs
+		upOffsets.assign(nNodes + 1, 0);
+		downOffsets.assign(nNodes + 1, 0);
+
+		for (uint32_t v = 0; v < nNodes; ++v)
+		{
+			upOffsets[v + 1] = upOffsets[v] + static_cast<uint32_t>(upOf[v].size());
+			downOffsets[v + 1] = downOffsets[v] + static_cast<uint32_t>(downOf[v].size());
+			upArcs.insert(upArcs.end(), upOf[v].begin(), upOf[v].end());
+			downArcs.insert(downArcs.end(), downOf[v].begin(), downOf[v].end());
+		}
+
+		built = true;
+	}
+
+	void ContractionHierarchy::clear()
+	{
+		arcs.clear();
+		rank.clear();
+		upOffsets.clear();
+		upArcs.clear();
+		downOffsets.clear();
+		downArcs.clear();
+		shortcuts = 0;
+		allowed = 0;
+		built = false;
+	}
+
+	size_t ContractionHierarchy::memoryBytes() const
+	{
+		return arcs.capacity() * sizeof(arc)
+			+ (rank.capacity() + upOffsets.capacity() + upArcs.capacity() + downOffsets.capacity() + downArcs.capacity()) * sizeof(uint32_t);
+	}
+
+	void ContractionHierarchy::unpack(uint32_t arc_id, std::vector<uint32_t>& edges) const
+	{
+		std::vector<uint32_t> stack{ arc_id };
+
+		while (!stack.empty())
+		{
+			auto const& current = arcs[stack.back()];
+			stack.pop_back();
+
+			if (current.edge != NO_ARC)
+			{
+				edges.push_back(current.edge);
+				continue;
+			}
+
+			// Second half goes first so that the first half is unpacked first
+			stack.push_back(current.childB);
+			stack.push_back(current.childA);
+		}
+	}
+
+	void ContractionHierarchy::reset(workspace& ws) const
+	{
+		size_t const nNodes = rank.size();
+
+		if (ws.distF.size() != nNodes)
+		{
+			ws.distF.assign(nNodes, INF);
+			ws.distB.assign(nNodes, INF);
+			ws.parentF.assign(nNodes, NO_ARC);
+			ws.parentB.assign(nNodes, NO_ARC);
+			ws.fees.assign(nNodes, 0.0);
+			ws.touched.clear();
+		}
+
+		for (auto const v : ws.touched)
+		{
+			ws.distF[v] = ws.distB[v] = INF;
+			ws.parentF[v] = ws.parentB[v] = NO_ARC;
+		}
+		ws.touched.clear();
+	}
+
+	void ContractionHierarchy::upwardSearch(uint32_t node, bool forward, workspace& ws, std::vector<reached>& space) const
+	{
+		space.clear();
+		reset(ws);
+
+		minheap heap;
+		ws.distF[node] = 0.0;
+		ws.fees[node] = 0.0;
+		ws.touched.push_back(node);
+		heap.emplace(0.0, node);
+
+		while (!heap.empty())
+		{
+			auto [d, u] = heap.top();
+			heap.pop();
+
+			if (d > ws.distF[u]) continue;
+
+			// The fee was set by the last improvement of d, so it is the fee of the shortest way
+			space.push_back({ u, d, ws.fees[u] });
+
+			uint32_t begin = forward ? upOffsets[u] : downOffsets[u];
+			uint32_t end = forward ? upOffsets[u + 1] : downOffsets[u + 1];
+
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				uint32_t a = forward ? upArcs[i] : downArcs[i];
+				uint32_t v = forward ? arcs[a].to : arcs[a].from;
+				double nd = d + arcs[a].weight;
+
+				if (nd < ws.distF[v])
+				{
+					if (ws.distF[v] == INF) ws.touched.push_back(v);
+					ws.distF[v] = nd;
+					ws.fees[v] = ws.fees[u] + arcs[a].fee;
+					heap.emplace(nd, v);
+				}
+			}
+		}
+	}
+
+	searchResult ContractionHierarchy::query(GraphSnapshot const& graph, uint32_t source, uint32_t goal, workspace& ws) const
+	{
+		searchResult result;
+		reset(ws);
+
+		minheap forward;
+		minheap backward;
+
+		ws.distF[source] = 0.0;
+		ws.distB[goal] = 0.0;
+		ws.touched.push_back(source);
+		ws.touched.push_back(goal);
+		forward.emplace(0.0, source);
+		backward.emplace(0.0, goal);
+
+		double mu = INF;
+		uint32_t meet = GraphSnapshot::NO_NODE;
+
+		if (source == goal)
+		{
+			mu = 0.0;
+			meet = source;
+		}
+
+		// Each side stops once its frontier cannot improve on mu anymore
+		while ((!forward.empty() && forward.top().first < mu) || (!backward.empty() && backward.top().first < mu))
+		{
+			bool forward_turn = !forward.empty() && forward.top().first < mu
+				&& (backward.empty() || backward.top().first >= mu || forward.size() <= backward.size());
+
+			minheap& heap = forward_turn ? forward : backward;
+			std::vector<double>& dist = forward_turn ? ws.distF : ws.distB;
+			std::vector<double>& other = forward_turn ? ws.distB : ws.distF;
+			std::vector<uint32_t>& parent = forward_turn ? ws.parentF : ws.parentB;
+
+			auto [d, u] = heap.top();
+			heap.pop();
+
+			if (d > dist[u]) continue;
+			++result.expanded;
+
+			if (other[u] < INF && d + other[u] < mu)
+			{
+				mu = d + other[u];
+				meet = u;
+			}
+
+			uint32_t begin = forward_turn ? upOffsets[u] : downOffsets[u];
+			uint32_t end = forward_turn ? upOffsets[u + 1] : downOffsets[u + 1];
+
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				uint32_t a = forward_turn ? upArcs[i] : downArcs[i];
+				uint32_t v = forward_turn ? arcs[a].to : arcs[a].from;
+				double nd = d + arcs[a].weight;
+
+				if (nd < dist[v])
+				{
+					if (ws.distF[v] == INF && ws.distB[v] == INF) ws.touched.push_back(v);
+					dist[v] = nd;
+					parent[v] = a;
+					heap.emplace(nd, v);
+				}
+			}
+		}
+
+		if (meet == GraphSnapshot::NO_NODE)
+			return result;
+
+		auto const unpacking = std::chrono::steady_clock::now();
+
+		std::vector<uint32_t> up;
+		for (uint32_t v = meet; v != source; v = arcs[ws.parentF[v]].from)
+			up.push_back(ws.parentF[v]);
+		std::reverse(up.begin(), up.end());
+
+		std::vector<uint32_t> edges;
+		for (auto const a : up)
+			unpack(a, edges);
+
+		for (uint32_t v = meet; v != goal; v = arcs[ws.parentB[v]].to)
+			unpack(ws.parentB[v], edges);
+
+		graph.toLegs(edges, result.path);
+		result.reconstructionMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - unpacking).count();
+		result.cost = mu;
+		result.found = true;
+		return result;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "PathTypes.h"
+#include "GraphSnapshot.h"
+
+
+namespace paths
+{
+	/**
+	 * Contraction Hierarchy over the connections of a GraphSnapshot usable by a given set of vehicles,
+	 * minimising the travelled distance.
+	 *
+	 * build() contracts every place in order of importance, adding a shortcut arc whenever the contracted
+	 * place lies on the only shortest path between two of its neighbours. Queries are then a bidirectional
+	 * Dijkstra that only ever climbs towards more important places, and shortcuts are unpacked back into
+	 * the original "Connection" edges before the path is handed out.
+	 */
+	class ContractionHierarchy
+	{
+	public:
+		/**
+		 * Per-query scratch space, sized on first use and reset lazily through the list of touched nodes.
+		 */
+		struct workspace
+		{
+			std::vector<double> distF;
+			std::vector<double> distB;
+			std::vector<uint32_t> parentF;
+			std::vector<uint32_t> parentB;
+			std::vector<double> fees;		// upward searches only, fee of the way to each place
+			std::vector<uint32_t> touched;
+		};
+
+		/**
+		 * A place settled by an upward search, with the distance and the fee of the shortest way there.
+		 */
+		struct reached
+		{
+			uint32_t node;
+			double distance;
+			double fee;
+		};
+
+		void build(GraphSnapshot const& graph, char allowed_vehicles);
+		void clear();
+
+		bool isBuilt() const { return built; }
+		char getAllowedVehicles() const { return allowed; }
+
+		searchResult query(GraphSnapshot const& graph, uint32_t source, uint32_t goal, workspace& ws) const;
+
+		/**
+		 * One half of a query run to exhaustion: every place reachable from node (forward) or reaching it
+		 * (backward) by only climbing the hierarchy, the search space many-to-many searches combine.
+		 *
+		 * \param space  Receives the settled places, in settling order.
+		 */
+		void upwardSearch(uint32_t node, bool forward, workspace& ws, std::vector<reached>& space) const;
+
+		size_t arcCount() const { return arcs.size(); }
+		size_t shortcutCount() const { return shortcuts; }
+		size_t memoryBytes() const;
+
+	private:
+		struct arc
+		{
+			uint32_t from;
+			uint32_t to;
+			double weight;
+			double fee;			// of the connections the arc stands for
+			uint32_t childA;	// shortcuts: from -> middle
+			uint32_t childB;	// shortcuts: middle -> to
+			uint32_t edge;		// original arcs: edge ID in the snapshot
+		};
+
+		void unpack(uint32_t arc_id, std::vector<uint32_t>& edges) const;
+
+		/**
+		 * Sizes the workspace for the hierarchy and wipes what the previous search touched.
+		 */
+		void reset(workspace& ws) const;
+
+		std::vector<arc> arcs;
+		std::vector<uint32_t> rank;
+
+		std::vector<uint32_t> upOffsets;		// arcs towards more important places, grouped by arc.from
+		std::vector<uint32_t> upArcs;
+		std::vector<uint32_t> downOffsets;		// arcs coming from more important places, grouped by arc.to
+		std::vector<uint32_t> downArcs;
+
+		size_t shortcuts = 0;
+		char allowed = 0;
+		bool built = false;
+	};
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include "PathTypes.h"
+#include "GraphSnapshot.h"
+
+
+namespace paths
+{
+	/*
+
+	Cost policies, one type per "special option" so that the searches are instantiated once per policy
+	and the per-edge pricing compiles down to a couple of multiplications instead of a switch.
+
+	A policy provides:
+	    cost(graph, edge)      the price of taking a connection, never below its distance;
+	    heuristic(distance)    a lower bound on the price of travelling at least that distance.
+
+	The searches feed heuristic() with a consistent lower bound on the distance left (the straight line or
+	landmarks, see DistanceBounds.h), so as long as every cost is at least the distance the heuristic is both
+	admissible and consistent, and A* stays optimal for every policy.
+
+	*/
+
+	struct ShortestPolicy
+	{
+		static constexpr const char* name = "Shortest";
+
+		double cost(GraphSnapshot const& graph, uint32_t edge) const { return graph.distance(edge); }
+		double heuristic(double distance) const { return distance; }
+	};
+
+	struct PreferCarPolicy
+	{
+		static constexpr const char* name = "Prefer cars";
+
+		double cost(GraphSnapshot const& graph, uint32_t edge) const
+		{
+			return graph.distance(edge) * (graph.vehicle(edge) == CAR ? 1.0 : 10.0);
+		}
+		double heuristic(double distance) const { return distance; }
+	};
+
+	template<VehicleType Avoided>
+	struct AvoidModePolicy
+	{
+		static constexpr const char* name = (Avoided == PLANE) ? "Discourage planes" : ((Avoided == SHIP) ? "Discourage ships" : "Discourage cars");
+
+		double cost(GraphSnapshot const& graph, uint32_t edge) const
+		{
+			return graph.distance(edge) * (graph.vehicle(edge) == Avoided ? 100.0 : 1.0);
+		}
+		double heuristic(double distance) const { return distance; }
+	};
+
+	struct CheapestPolicy
+	{
+		static constexpr const char* name = "Less costly";
+
+		double cost(GraphSnapshot const& graph, uint32_t edge) const
+		{
+			return graph.distance(edge) * (1.0 + graph.fee(edge) * 100.0);
+		}
+		double heuristic(double distance) const { return distance; }
+	};
+
+	/**
+	 * Linear blend of distance and fee, feeWeight being how many distance units a unit of fee is worth.
+	 */
+	struct BlendPolicy
+	{
+		static constexpr const char* name = "Balanced";
+		static constexpr double DEFAULT_FEE_WEIGHT = 100.0;
+
+		double feeWeight = DEFAULT_FEE_WEIGHT;
+
+		double cost(GraphSnapshot const& graph, uint32_t edge) const
+		{
+			return graph.distance(edge) + feeWeight * graph.fee(edge);
+		}
+		double heuristic(double distance) const { return distance; }
+	};
+
+	/**
+	 * Weighted A* over any policy: the heuristic is inflated by weight, so the search expands fewer places
+	 * and the route found costs at most weight times the optimum (the base heuristic being consistent, this
+	 * holds even though closed places are never reopened). Only meant for the unidirectional search.
+	 */
+	template<class Policy>
+	struct Weighted : Policy
+	{
+		double weight = 1.0;
+
+		double heuristic(double distance) const { return weight * Policy::heuristic(distance); }
+	};
+
+	constexpr short POLICY_COUNT = 6;
+
+	/**
+	 * Maps a "special option" of the pathfinder onto its policy and calls visit with it, so the switch
+	 * is taken once per search rather than once per relaxed edge.
+	 */
+	template<class Visitor>
+	decltype(auto) withPolicy(short special_case, Visitor&& visit)
+	{
+		switch (special_case)
+		{
+		case 1: // Prefer cars
+			return visit(PreferCarPolicy{});
+		case 2: // Discourage planes
+			return visit(AvoidModePolicy<PLANE>{});
+		case 3: // Discourage ships
+			return visit(AvoidModePolicy<SHIP>{});
+		case 4: // Less costly
+			return visit(CheapestPolicy{});
+		case 5: // Balanced
+			return visit(BlendPolicy{});
+		default:
+			return visit(ShortestPolicy{});
+		}
+	}
+}
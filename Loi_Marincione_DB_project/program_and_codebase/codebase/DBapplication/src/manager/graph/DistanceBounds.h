@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include "GraphSnapshot.h"
+#include "LandmarkTable.h"
+
+
+namespace paths
+{
+	/*
+
+	Lower bounds on the travelled distance between places, what the cost policies turn into A* heuristics.
+
+	A bound is set up once per query, for its source and goal, and provides:
+	    toGoal(v)                  a lower bound on d(v, goal);
+	    fromSource(v)              a lower bound on d(source, v), for backward searches;
+	    toGoalBatch(nodes, n, out) toGoal over a batch of places.
+
+	Both kinds are consistent (|bound(u) - bound(v)| never exceeds the connection u -> v), so closed places
+	never need reopening and the bidirectional potentials keep reduced costs non-negative.
+
+	*/
+
+	/**
+	 * The straight line between places, always available.
+	 */
+	struct EuclideanBound
+	{
+		static constexpr const char* name = "Euclidean";
+
+		PlaceTable const& places;
+		uint32_t source;
+		uint32_t goal;
+
+		EuclideanBound(GraphSnapshot const& graph, uint32_t source, uint32_t goal) : places(graph.getPlaces()), source(source), goal(goal) {}
+
+		double toGoal(uint32_t v) const { return places.distance(v, goal); }
+		double fromSource(uint32_t v) const { return places.distance(source, v); }
+
+		void toGoalBatch(uint32_t const* nodes, size_t n, double* out) const { places.distanceBatch(nodes, n, goal, out); }
+	};
+
+	/**
+	 * ALT: the best of the straight line and the triangle inequality bounds of a few landmarks.
+	 *
+	 * Only the ACTIVE landmarks giving the best bound between source and goal are consulted, picked once per
+	 * query so the bound stays consistent; those are the ones that pay off along the way, and checking a few
+	 * keeps every evaluation cheap. Landmarks some end of the query cannot reach or be reached from are skipped.
+	 * Without landmarks this is the Euclidean bound.
+	 */
+	struct LandmarkBound
+	{
+		static constexpr const char* name = "Landmarks";
+		static constexpr size_t ACTIVE = 4;
+		static constexpr double INF = std::numeric_limits<double>::infinity();
+
+		EuclideanBound straight;
+		LandmarkTable const& table;
+
+		size_t active = 0;
+		uint32_t chosen[ACTIVE];
+		double sourceFrom[ACTIVE];	// d(landmark, source)
+		double sourceTo[ACTIVE];	// d(source, landmark)
+		double goalFrom[ACTIVE];	// d(landmark, goal)
+		double goalTo[ACTIVE];		// d(goal, landmark)
+
+		LandmarkBound(GraphSnapshot const& graph, uint32_t source, uint32_t goal) : straight(graph, source, goal), table(graph.getLandmarks())
+		{
+			double best[ACTIVE];
+
+			for (uint32_t k = 0; k < table.size(); ++k)
+			{
+				double const fs = table.from(k, source), ts = table.to(k, source);
+				double const fg = table.from(k, goal), tg = table.to(k, goal);
+
+				if (fs == INF || ts == INF || fg == INF || tg == INF)
+					continue;
+
+				// Insertion into the ACTIVE best so far, by their bound on d(source, goal)
+				double const bound = std::max(fg - fs, ts - tg);
+				size_t slot = std::min(active, ACTIVE - 1);
+
+				if (active == ACTIVE && bound <= best[slot])
+					continue;
+
+				for (; slot > 0 && best[slot - 1] < bound; --slot)
+				{
+					best[slot] = best[slot - 1];
+					chosen[slot] = chosen[slot - 1];
+					sourceFrom[slot] = sourceFrom[slot - 1];
+					sourceTo[slot] = sourceTo[slot - 1];
+					goalFrom[slot] = goalFrom[slot - 1];
+					goalTo[slot] = goalTo[slot - 1];
+				}
+
+				best[slot] = bound;
+				chosen[slot] = k;
+				sourceFrom[slot] = fs;
+				sourceTo[slot] = ts;
+				goalFrom[slot] = fg;
+				goalTo[slot] = tg;
+				active = std::min(active + 1, ACTIVE);
+			}
+		}
+
+		double toGoal(uint32_t v) const
+		{
+			double bound = straight.toGoal(v);
+			for (size_t a = 0; a < active; ++a)
+				bound = std::max({ bound, goalFrom[a] - table.from(chosen[a], v), table.to(chosen[a], v) - goalTo[a] });
+			return bound;
+		}
+
+		double fromSource(uint32_t v) const
+		{
+			double bound = straight.fromSource(v);
+			for (size_t a = 0; a < active; ++a)
+				bound = std::max({ bound, table.from(chosen[a], v) - sourceFrom[a], sourceTo[a] - table.to(chosen[a], v) });
+			return bound;
+		}
+
+		void toGoalBatch(uint32_t const* nodes, size_t n, double* out) const
+		{
+			straight.toGoalBatch(nodes, n, out);
+
+			for (size_t a = 0; a < active; ++a)
+			{
+				for (size_t i = 0; i < n; ++i)
+					out[i] = std::max({ out[i], goalFrom[a] - table.from(chosen[a], nodes[i]), table.to(chosen[a], nodes[i]) - goalTo[a] });
+			}
+		}
+	};
+}
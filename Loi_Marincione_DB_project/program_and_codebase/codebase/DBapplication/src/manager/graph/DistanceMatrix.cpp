@@ -0,0 +1,292 @@
+#include "DistanceMatrix.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+
+namespace paths
+{
+	namespace
+	{
+		constexpr double INF = std::numeric_limits<double>::infinity();
+
+		/*
+
+		File layout, little-endian: matrixHeader, then centers x int64_t IDs, centers^2 float distances
+		and centers^2 float fees, row-major. Any change of the layout must bump MATRIX_FORMAT.
+
+		*/
+		constexpr char MATRIX_MAGIC[8] = { 'D', 'B', 'M', 'A', 'T', 'R', 'I', 'X' };
+		constexpr uint32_t MATRIX_FORMAT = 1;
+
+		struct matrixHeader
+		{
+			char magic[8];
+			uint32_t format;
+			uint32_t headerBytes;		// sizeof(matrixHeader) of the writer
+			int64_t graphVersion;
+			uint64_t centers;
+			uint8_t allowedVehicles;
+			uint8_t unused[7];
+		};
+
+		/**
+		 * An entry of the forward search space of a Center, filed under the place it settled.
+		 */
+		struct bucketEntry
+		{
+			uint32_t row;
+			double distance;
+			double fee;
+		};
+
+		/**
+		 * Runs body(i, workspace) for every i in [0, count) on a pool of threads, each with a workspace of its own.
+		 */
+		template<class Body>
+		void parallelFor(size_t count, Body const& body)
+		{
+			std::atomic<size_t> next{ 0 };
+			auto worker = [&]() {
+				ContractionHierarchy::workspace ws;
+				for (size_t i = next++; i < count; i = next++)
+					body(i, ws);
+			};
+
+			size_t const nWorkers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), count));
+			std::vector<std::thread> pool;
+			pool.reserve(nWorkers - 1);
+			for (size_t t = 1; t < nWorkers; ++t)
+				pool.emplace_back(worker);
+			worker();
+			for (auto& thread : pool)
+				thread.join();
+		}
+	}
+
+	void DistanceMatrix::compute(GraphSnapshot const& graph, ContractionHierarchy const& hierarchy, std::vector<int64_t> const& centers,
+		std::vector<uint32_t> const& nodes, int64_t version)
+	{
+		clear();
+		this->centers = centers;
+		this->version = version;
+		allowed = hierarchy.getAllowedVehicles();
+
+		size_t const n = centers.size();
+		distances.assign(n * n, UNREACHABLE);
+		fees.assign(n * n, UNREACHABLE);
+
+		if (n == 0 || !hierarchy.isBuilt())
+			return;
+
+		std::atomic<size_t> settledCount{ 0 };
+
+		/*
+
+		Forward round: the upward search space of every Center, sorted into buckets by place
+
+		*/
+		std::vector<std::vector<ContractionHierarchy::reached>> spaces(n);
+		parallelFor(n, [&](size_t i, ContractionHierarchy::workspace& ws) {
+			if (nodes[i] != GraphSnapshot::NO_NODE)
+				hierarchy.upwardSearch(nodes[i], true, ws, spaces[i]);
+			settledCount += spaces[i].size();
+		});
+
+		std::vector<uint32_t> offsets(graph.nodeCount() + 1, 0);
+		for (auto const& space : spaces)
+			for (auto const& entry : space)
+				++offsets[entry.node + 1];
+
+		for (size_t v = 0; v < graph.nodeCount(); ++v)
+			offsets[v + 1] += offsets[v];
+
+		std::vector<bucketEntry> buckets(offsets.back());
+		{
+			std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+			for (uint32_t i = 0; i < n; ++i)
+			{
+				for (auto const& entry : spaces[i])
+					buckets[cursor[entry.node]++] = { i, entry.distance, entry.fee };
+				std::vector<ContractionHierarchy::reached>().swap(spaces[i]);
+			}
+		}
+
+		/*
+
+		Backward round: every Center fills its column from the buckets of the places its search settles
+
+		*/
+		parallelFor(n, [&](size_t j, ContractionHierarchy::workspace& ws) {
+			if (nodes[j] == GraphSnapshot::NO_NODE)
+				return;
+
+			thread_local std::vector<ContractionHierarchy::reached> space;
+			thread_local std::vector<double> best;
+			thread_local std::vector<double> bestFee;
+
+			hierarchy.upwardSearch(nodes[j], false, ws, space);
+			settledCount += space.size();
+
+			best.assign(n, INF);
+			bestFee.assign(n, INF);
+
+			for (auto const& reached : space)
+			{
+				for (uint32_t b = offsets[reached.node]; b < offsets[reached.node + 1]; ++b)
+				{
+					auto const& entry = buckets[b];
+					double const d = entry.distance + reached.distance;
+					if (d < best[entry.row])
+					{
+						best[entry.row] = d;
+						bestFee[entry.row] = entry.fee + reached.fee;
+					}
+				}
+			}
+
+			// Each worker writes its own columns only
+			for (size_t i = 0; i < n; ++i)
+			{
+				if (best[i] < INF)
+				{
+					distances[i * n + j] = static_cast<float>(best[i]);
+					fees[i * n + j] = static_cast<float>(bestFee[i]);
+				}
+			}
+		});
+
+		settled = settledCount;
+	}
+
+	bool DistanceMatrix::save(std::string const& path) const
+	{
+		matrixHeader header{};
+		std::memcpy(header.magic, MATRIX_MAGIC, sizeof(header.magic));
+		header.format = MATRIX_FORMAT;
+		header.headerBytes = sizeof(header);
+		header.graphVersion = version;
+		header.centers = centers.size();
+		header.allowedVehicles = static_cast<uint8_t>(allowed);
+
+		std::string const temporary = path + ".tmp";
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			std::cerr << "Could not create " << temporary << "!" << std::endl;
+			return false;
+		}
+
+		out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		out.write(reinterpret_cast<char const*>(centers.data()), centers.size() * sizeof(int64_t));
+		out.write(reinterpret_cast<char const*>(distances.data()), distances.size() * sizeof(float));
+		out.write(reinterpret_cast<char const*>(fees.data()), fees.size() * sizeof(float));
+		out.close();
+
+		if (!out)
+		{
+			std::cerr << "Could not write " << temporary << "!" << std::endl;
+			return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		if (error)
+		{
+			std::cerr << "Could not replace " << path << ": " << error.message() << std::endl;
+			std::filesystem::remove(temporary, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool DistanceMatrix::load(std::string const& path)
+	{
+		clear();
+
+		std::ifstream in(path, std::ios::binary);
+		matrixHeader header{};
+
+		if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, MATRIX_MAGIC, sizeof(header.magic)) != 0
+			|| header.format != MATRIX_FORMAT || header.headerBytes != sizeof(header))
+		{
+			std::cerr << path << " is not a distance matrix file of this version." << std::endl;
+			return false;
+		}
+
+		std::error_code error;
+		uint64_t const n = header.centers;
+		uint64_t const expected = sizeof(header) + n * sizeof(int64_t) + 2 * n * n * sizeof(float);
+		if (std::filesystem::file_size(path, error) != expected || error)
+		{
+			std::cerr << path << " is damaged, ignoring it." << std::endl;
+			return false;
+		}
+
+		centers.resize(n);
+		distances.resize(n * n);
+		fees.resize(n * n);
+
+		in.read(reinterpret_cast<char*>(centers.data()), n * sizeof(int64_t));
+		in.read(reinterpret_cast<char*>(distances.data()), n * n * sizeof(float));
+		in.read(reinterpret_cast<char*>(fees.data()), n * n * sizeof(float));
+
+		if (!in)
+		{
+			std::cerr << "Could not read " << path << "!" << std::endl;
+			clear();
+			return false;
+		}
+
+		version = header.graphVersion;
+		allowed = static_cast<char>(header.allowedVehicles);
+		return true;
+	}
+
+	bool DistanceMatrix::writeCsv(std::string const& path) const
+	{
+		std::ofstream out(path, std::ios::trunc);
+		if (!out)
+		{
+			std::cerr << "Could not create " << path << "!" << std::endl;
+			return false;
+		}
+
+		out.precision(std::numeric_limits<float>::max_digits10);
+		out << "from,to,distance,fee\n";
+
+		size_t const n = size();
+		for (size_t i = 0; i < n; ++i)
+		{
+			for (size_t j = 0; j < n; ++j)
+			{
+				if (i != j && distance(i, j) != UNREACHABLE)
+					out << centers[i] << ',' << centers[j] << ',' << distance(i, j) << ',' << fee(i, j) << '\n';
+			}
+		}
+
+		out.close();
+		if (!out)
+		{
+			std::cerr << "Could not write " << path << "!" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	void DistanceMatrix::clear()
+	{
+		centers.clear();
+		distances.clear();
+		fees.clear();
+		version = 0;
+		allowed = 0;
+		settled = 0;
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "PathTypes.h"
+#include "GraphSnapshot.h"
+#include "ContractionHierarchy.h"
+
+
+namespace paths
+{
+	/**
+	 * Shortest travelled distance, and the fee of that route, between every ordered pair of a set of Centers of Interest.
+	 *
+	 * compute() runs the bucket-based many-to-many search over a Contraction Hierarchy: one upward search per
+	 * Center forwards and one backwards, the forward search spaces are sorted into per-place buckets, and every
+	 * backward search only scans the buckets of the places it settles. That costs 2n upward searches instead
+	 * of n^2 queries; both rounds are spread over a pool of worker threads.
+	 *
+	 * Entries are floats in row-major order (row = from, column = to), UNREACHABLE where there is no route.
+	 * save() writes them to a binary file other tools can load() back, writeCsv() a plain listing.
+	 */
+	class DistanceMatrix
+	{
+	public:
+		static constexpr float UNREACHABLE = std::numeric_limits<float>::infinity();
+
+		/**
+		 * Fills the matrix, replacing the current contents.
+		 *
+		 * \param hierarchy  Built over graph, its vehicles are the ones the routes may use.
+		 * \param centers    IDs of the Centers of Interest, rows and columns follow this order.
+		 * \param nodes      Place of every Center in the graph, NO_NODE leaves its row and column unreachable.
+		 * \param version    "ConnectionVersion" of the graph, recorded in the saved file.
+		 */
+		void compute(GraphSnapshot const& graph, ContractionHierarchy const& hierarchy, std::vector<int64_t> const& centers,
+			std::vector<uint32_t> const& nodes, int64_t version);
+
+		/**
+		 * Writes the matrix to path, through a temporary file renamed over it.
+		 */
+		bool save(std::string const& path) const;
+
+		/**
+		 * Reads a file written by save(), replacing the current contents.
+		 *
+		 * \return  False if the file is missing, of another format or truncated, the matrix is empty then.
+		 */
+		bool load(std::string const& path);
+
+		/**
+		 * Writes one "from,to,distance,fee" line per reachable pair of distinct Centers.
+		 */
+		bool writeCsv(std::string const& path) const;
+
+		void clear();
+
+		size_t size() const { return centers.size(); }
+		int64_t centerAt(size_t i) const { return centers[i]; }
+
+		float distance(size_t from, size_t to) const { return distances[from * size() + to]; }
+		float fee(size_t from, size_t to) const { return fees[from * size() + to]; }
+
+		int64_t getVersion() const { return version; }
+		char getAllowedVehicles() const { return allowed; }
+
+		// Places settled by all the upward searches of the last compute()
+		size_t getSettled() const { return settled; }
+
+		size_t memoryBytes() const
+		{
+			return centers.capacity() * sizeof(int64_t) + (distances.capacity() + fees.capacity()) * sizeof(float);
+		}
+
+	private:
+		std::vector<int64_t> centers;
+		std::vector<float> distances;
+		std::vector<float> fees;
+
+		int64_t version = 0;
+		char allowed = 0;
+		size_t settled = 0;
+	};
+}
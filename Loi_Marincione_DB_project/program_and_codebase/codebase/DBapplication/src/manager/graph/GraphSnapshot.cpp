@@ -0,0 +1,568 @@
+#include "GraphSnapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <unordered_map>
+#include "SnapshotFormat.h"
+#include "../../DButils/queries.h"
+#include "../../DButils/ResultView.h"
+
+
+namespace paths
+{
+	struct GraphSnapshot::rawEdge
+	{
+		uint32_t from;
+		uint32_t to;
+		double distance;
+		double fee;
+		VehicleType vehicle;
+
+		bool operator<(rawEdge const& other) const
+		{
+			return std::tie(from, to, distance, vehicle, fee) < std::tie(other.from, other.to, other.distance, other.vehicle, other.fee);
+		}
+	};
+
+	namespace
+	{
+		uint32_t denseIndex(std::unordered_map<int64_t, uint32_t>& index, std::vector<int64_t>& ids, int64_t place)
+		{
+			auto [it, inserted] = index.try_emplace(place, static_cast<uint32_t>(ids.size()));
+			if (inserted)
+				ids.push_back(place);
+			return it->second;
+		}
+
+		/**
+		 * Points column at count elements of the section, if the section has exactly that size.
+		 */
+		template<class T>
+		bool borrowSection(Column<T>& column, MappedFile const& file, snapshotHeader const& header, snapshotSection section, uint64_t count)
+		{
+			auto const& extent = header.sections[section];
+
+			if (extent.bytes != count * sizeof(T) || extent.offset % SNAPSHOT_ALIGNMENT != 0 || extent.offset + extent.bytes > file.size())
+				return false;
+
+			column.borrow(reinterpret_cast<T const*>(file.data() + extent.offset), static_cast<size_t>(count));
+			return true;
+		}
+	}
+
+	bool readConnectionVersion(PGconn* const& conn, int64_t& version)
+	{
+		PGresult* res = nullptr;
+		if (!(query::executeQuery("SELECT CASE WHEN is_called THEN last_value ELSE 0 END FROM public.\"ConnectionVersion\";", res, conn, query::resultFormat::BINARY)
+			&& PQntuples(res) > 0))
+		{
+			PQclear(res);
+			return false;
+		}
+
+		version = query::resultView(res).integer(0, 0);
+		PQclear(res);
+		return true;
+	}
+
+	bool GraphSnapshot::load(PGconn* const& conn)
+	{
+		clear();
+
+		// Both tables as of the same moment, so no connection refers to a place the first query missed
+		query::readSnapshot snapshot(conn);
+
+		PGresult* res = nullptr;
+		if (!query::executeQuery("SELECT \"ID\", \"Position\"[0], \"Position\"[1] FROM public.\"Place\" ORDER BY \"ID\"", res, conn, query::resultFormat::BINARY))
+		{
+			std::cerr << "Could not load the Place table for the pathfinder!" << std::endl;
+			PQclear(res);
+			return false;
+		}
+
+		query::resultView places(res);
+		auto const place_ids = places.get<int64_t>(0);
+		auto const place_xs = places.get<double>(1);
+		auto const place_ys = places.get<double>(2);
+
+		std::vector<placeRow> place_rows(places.rows());
+		for (int i = 0; i < places.rows(); ++i)
+			place_rows[i] = { place_ids[i], place_xs[i], place_ys[i] };
+		PQclear(res);
+
+		if (!query::executeQuery("SELECT \"PlaceA\", \"PlaceB\", \"AllowedVehicles\", fee, distance FROM public.\"Connection\"", res, conn, query::resultFormat::BINARY))
+		{
+			std::cerr << "Could not load the Connection table for the pathfinder!" << std::endl;
+			PQclear(res);
+			return false;
+		}
+
+		query::resultView connections(res);
+		auto const from_ids = connections.get<int64_t>(0);
+		auto const to_ids = connections.get<int64_t>(1);
+		auto const vehicles = connections.get<std::string_view>(2);
+		auto const fees = connections.get<double>(3);
+		auto const distances = connections.get<double>(4);
+
+		std::vector<connectionRow> connection_rows(connections.rows());
+		for (int i = 0; i < connections.rows(); ++i)
+			connection_rows[i] = { from_ids[i], to_ids[i], toVehicle(vehicles[i]), fees[i], distances[i] };
+		PQclear(res);
+
+		assign(place_rows, connection_rows);
+		return true;
+	}
+
+	void GraphSnapshot::assign(std::vector<placeRow> const& place_rows, std::vector<connectionRow> const& connection_rows)
+	{
+		clear();
+
+		std::unordered_map<int64_t, uint32_t> dense;
+		std::vector<int64_t> node_ids;
+		std::vector<double> xs;
+		std::vector<double> ys;
+
+		dense.reserve(place_rows.size());
+		node_ids.reserve(place_rows.size());
+		xs.reserve(place_rows.size());
+		ys.reserve(place_rows.size());
+
+		for (auto const& row : place_rows)
+		{
+			uint32_t node = denseIndex(dense, node_ids, row.id);
+			xs.resize(node_ids.size(), 0.0);
+			ys.resize(node_ids.size(), 0.0);
+			xs[node] = row.x;
+			ys[node] = row.y;
+		}
+
+		std::vector<rawEdge> edges;
+		edges.reserve(connection_rows.size());
+
+		for (auto const& row : connection_rows)
+		{
+			uint32_t from = denseIndex(dense, node_ids, row.from);
+			uint32_t to   = denseIndex(dense, node_ids, row.to);
+
+			edges.push_back({ from, to, row.distance, row.fee, row.vehicle });
+		}
+
+		// Endpoints missing from "Place" should not exist, they just get no coordinates
+		xs.resize(node_ids.size(), 0.0);
+		ys.resize(node_ids.size(), 0.0);
+
+		std::vector<placeIndex> sorted;
+		sorted.reserve(node_ids.size());
+		for (uint32_t node = 0; node < node_ids.size(); ++node)
+			sorted.push_back({ node_ids[node], node, 0 });
+		std::sort(sorted.begin(), sorted.end(), [](placeIndex const& l, placeIndex const& r) { return l.place < r.place; });
+
+		index.assign(std::move(sorted));
+		ids.assign(std::move(node_ids));
+		places.xs.assign(std::move(xs));
+		places.ys.assign(std::move(ys));
+
+		std::sort(edges.begin(), edges.end());
+		build(edges);
+
+		loaded = true;
+	}
+
+	uint32_t GraphSnapshot::indexOf(int64_t place) const
+	{
+		auto it = std::lower_bound(index.begin(), index.end(), place, [](placeIndex const& entry, int64_t id) { return entry.place < id; });
+		return (it == index.end() || it->place != place) ? NO_NODE : it->node;
+	}
+
+	bool GraphSnapshot::apply(std::vector<edgeDelta> const& deltas)
+	{
+		if (deltas.empty())
+			return true;
+
+		detach();
+
+		// Only the last change of every key counts, and it replaces whatever edge has that key now
+		std::map<std::tuple<uint32_t, uint32_t, VehicleType>, edgeDelta const*> latest;
+		std::vector<bool> replaced(edgeCount(), false);
+
+		for (auto const& delta : deltas)
+		{
+			uint32_t from = indexOf(delta.from);
+			uint32_t to = indexOf(delta.to);
+
+			if (from == NO_NODE || to == NO_NODE)
+			{
+				if (delta.removed) continue;
+				return false;
+			}
+
+			latest[{ from, to, delta.vehicle }] = &delta;
+
+			for (uint32_t edge = edgesBegin(from); edge < edgesEnd(from); ++edge)
+			{
+				if (targets[edge] == to && vehicle(edge) == delta.vehicle)
+					replaced[edge] = true;
+			}
+		}
+
+		std::vector<rawEdge> kept;
+		kept.reserve(edgeCount());
+		for (uint32_t edge = 0; edge < edgeCount(); ++edge)
+		{
+			if (!replaced[edge])
+				kept.push_back({ sources[edge], targets[edge], distances[edge], fees[edge], vehicle(edge) });
+		}
+
+		std::vector<rawEdge> inserted;
+		for (auto const& [key, delta] : latest)
+		{
+			if (!delta->removed)
+				inserted.push_back({ std::get<0>(key), std::get<1>(key), delta->distance, delta->fee, delta->vehicle });
+		}
+		std::sort(inserted.begin(), inserted.end());
+
+		bool const keeps_landmarks = std::all_of(inserted.begin(), inserted.end(), [&](rawEdge const& edge) {
+			return landmarks.keepsExact(edge.from, edge.to, edge.distance);
+		});
+		if (!keeps_landmarks)
+			landmarks.clear();
+
+		std::vector<rawEdge> edges;
+		edges.reserve(kept.size() + inserted.size());
+		std::merge(kept.begin(), kept.end(), inserted.begin(), inserted.end(), std::back_inserter(edges));
+
+		build(edges);
+		return true;
+	}
+
+	void GraphSnapshot::build(std::vector<rawEdge> const& edges)
+	{
+		size_t const nNodes = ids.size();
+
+		std::vector<uint32_t> edge_offsets(nNodes + 1, 0);
+		std::vector<uint32_t> edge_sources;
+		std::vector<uint32_t> edge_targets;
+		std::vector<double> edge_distances;
+		std::vector<double> edge_fees;
+		std::vector<uint8_t> edge_vehicles;
+
+		edge_sources.reserve(edges.size());
+		edge_targets.reserve(edges.size());
+		edge_distances.reserve(edges.size());
+		edge_fees.reserve(edges.size());
+		edge_vehicles.reserve(edges.size());
+
+		for (auto const& edge : edges)
+		{
+			++edge_offsets[edge.from + 1];
+			edge_sources.push_back(edge.from);
+			edge_targets.push_back(edge.to);
+			edge_distances.push_back(edge.distance);
+			edge_fees.push_back(edge.fee);
+			edge_vehicles.push_back(static_cast<uint8_t>(edge.vehicle));
+		}
+
+		for (size_t n = 1; n < edge_offsets.size(); ++n)
+			edge_offsets[n] += edge_offsets[n - 1];
+
+		// Reverse adjacency, a counting sort of the edge IDs by target
+		std::vector<uint32_t> reverse_offsets(nNodes + 1, 0);
+		std::vector<uint32_t> reverse_edges(edge_targets.size());
+
+		for (auto const to : edge_targets)
+			++reverse_offsets[to + 1];
+
+		for (size_t n = 1; n < reverse_offsets.size(); ++n)
+			reverse_offsets[n] += reverse_offsets[n - 1];
+
+		std::vector<uint32_t> fill(reverse_offsets.begin(), reverse_offsets.end() - 1);
+		for (uint32_t edge = 0; edge < edge_targets.size(); ++edge)
+			reverse_edges[fill[edge_targets[edge]]++] = edge;
+
+		offsets.assign(std::move(edge_offsets));
+		sources.assign(std::move(edge_sources));
+		targets.assign(std::move(edge_targets));
+		distances.assign(std::move(edge_distances));
+		fees.assign(std::move(edge_fees));
+		vehicles.assign(std::move(edge_vehicles));
+		rOffsets.assign(std::move(reverse_offsets));
+		rEdges.assign(std::move(reverse_edges));
+	}
+
+	void GraphSnapshot::detach()
+	{
+		if (!mapping.isOpen())
+			return;
+
+		index.own();
+		ids.own();
+		offsets.own();
+		sources.own();
+		targets.own();
+		distances.own();
+		fees.own();
+		vehicles.own();
+		rOffsets.own();
+		rEdges.own();
+		places.xs.own();
+		places.ys.own();
+		landmarks.landmarks.own();
+		landmarks.fromLandmark.own();
+		landmarks.toLandmark.own();
+
+		mapping.close();
+	}
+
+	/*
+
+	Snapshot files
+
+	*/
+
+	bool GraphSnapshot::map(std::string const& path, int64_t& version, bool verify_checksum)
+	{
+		clear();
+
+		if (!mapping.open(path))
+			return false;
+
+		snapshotHeader header;
+		if (mapping.size() < sizeof(header))
+		{
+			clear();
+			return false;
+		}
+		std::memcpy(&header, mapping.data(), sizeof(header));
+
+		if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.format != SNAPSHOT_FORMAT
+			|| header.headerBytes != sizeof(header) || header.nodes >= NO_NODE || header.edges >= UINT32_MAX)
+		{
+			std::cerr << path << " is not a graph snapshot of this version of the application, ignoring it." << std::endl;
+			clear();
+			return false;
+		}
+
+		uint64_t const nodes = header.nodes;
+		uint64_t const edges = header.edges;
+		uint64_t const marks = header.landmarks;
+
+		bool fits = borrowSection(ids, mapping, header, SECTION_IDS, nodes)
+			&& borrowSection(index, mapping, header, SECTION_INDEX, nodes)
+			&& borrowSection(offsets, mapping, header, SECTION_OFFSETS, nodes + 1)
+			&& borrowSection(sources, mapping, header, SECTION_SOURCES, edges)
+			&& borrowSection(targets, mapping, header, SECTION_TARGETS, edges)
+			&& borrowSection(distances, mapping, header, SECTION_DISTANCES, edges)
+			&& borrowSection(fees, mapping, header, SECTION_FEES, edges)
+			&& borrowSection(vehicles, mapping, header, SECTION_VEHICLES, edges)
+			&& borrowSection(rOffsets, mapping, header, SECTION_REVERSE_OFFSETS, nodes + 1)
+			&& borrowSection(rEdges, mapping, header, SECTION_REVERSE_EDGES, edges)
+			&& borrowSection(places.xs, mapping, header, SECTION_XS, nodes)
+			&& borrowSection(places.ys, mapping, header, SECTION_YS, nodes)
+			&& borrowSection(landmarks.landmarks, mapping, header, SECTION_LANDMARKS, marks)
+			&& borrowSection(landmarks.fromLandmark, mapping, header, SECTION_LANDMARK_FROM, nodes * marks)
+			&& borrowSection(landmarks.toLandmark, mapping, header, SECTION_LANDMARK_TO, nodes * marks);
+
+		// The cheap checks, a truncated or mismatched file fails here without reading it all
+		if (!fits || offsets[nodes] != edges || rOffsets[nodes] != edges)
+		{
+			std::cerr << path << " is damaged, ignoring it." << std::endl;
+			clear();
+			return false;
+		}
+
+		if (verify_checksum && fnv1a(mapping.data() + sizeof(header), mapping.size() - sizeof(header)) != header.checksum)
+		{
+			std::cerr << path << " does not match its checksum, ignoring it." << std::endl;
+			clear();
+			return false;
+		}
+
+		version = header.graphVersion;
+		loaded = true;
+		return true;
+	}
+
+	bool GraphSnapshot::save(std::string const& path, int64_t version) const
+	{
+		snapshotHeader header{};
+		std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+		header.format = SNAPSHOT_FORMAT;
+		header.headerBytes = sizeof(header);
+		header.graphVersion = version;
+		header.nodes = nodeCount();
+		header.edges = edgeCount();
+		header.landmarks = landmarks.size();
+
+		std::pair<void const*, size_t> const contents[SECTION_COUNT] = {
+			{ ids.data(), ids.size() * sizeof(int64_t) },
+			{ index.data(), index.size() * sizeof(placeIndex) },
+			{ offsets.data(), offsets.size() * sizeof(uint32_t) },
+			{ sources.data(), sources.size() * sizeof(uint32_t) },
+			{ targets.data(), targets.size() * sizeof(uint32_t) },
+			{ distances.data(), distances.size() * sizeof(double) },
+			{ fees.data(), fees.size() * sizeof(double) },
+			{ vehicles.data(), vehicles.size() * sizeof(uint8_t) },
+			{ rOffsets.data(), rOffsets.size() * sizeof(uint32_t) },
+			{ rEdges.data(), rEdges.size() * sizeof(uint32_t) },
+			{ places.xs.data(), places.xs.size() * sizeof(double) },
+			{ places.ys.data(), places.ys.size() * sizeof(double) },
+			{ landmarks.landmarks.data(), landmarks.landmarks.size() * sizeof(uint32_t) },
+			{ landmarks.fromLandmark.data(), landmarks.fromLandmark.size() * sizeof(double) },
+			{ landmarks.toLandmark.data(), landmarks.toLandmark.size() * sizeof(double) },
+		};
+
+		uint64_t position = sizeof(header);
+		for (size_t section = 0; section < SECTION_COUNT; ++section)
+		{
+			position = (position + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+			header.sections[section] = { position, contents[section].second };
+			position += contents[section].second;
+		}
+
+		std::string const temporary = path + ".tmp";
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			std::cerr << "Could not create " << temporary << "!" << std::endl;
+			return false;
+		}
+
+		// The header goes in twice, the checksum is only known once everything after it was written
+		out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+		char const padding[SNAPSHOT_ALIGNMENT] = {};
+		uint64_t hash = fnv1a(nullptr, 0);
+		position = sizeof(header);
+
+		for (size_t section = 0; section < SECTION_COUNT; ++section)
+		{
+			size_t gap = static_cast<size_t>(header.sections[section].offset - position);
+			out.write(padding, gap);
+			hash = fnv1a(padding, gap, hash);
+
+			out.write(static_cast<char const*>(contents[section].first), contents[section].second);
+			hash = fnv1a(contents[section].first, contents[section].second, hash);
+
+			position = header.sections[section].offset + contents[section].second;
+		}
+
+		header.checksum = hash;
+		out.seekp(0);
+		out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		out.close();
+
+		if (!out)
+		{
+			std::cerr << "Could not write " << temporary << "!" << std::endl;
+			return false;
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		if (error)
+		{
+			std::cerr << "Could not replace " << path << ": " << error.message() << std::endl;
+			std::filesystem::remove(temporary, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool GraphSnapshot::validate(std::string& problem) const
+	{
+		std::stringstream out;
+		size_t const nNodes = nodeCount();
+		size_t const nEdges = edgeCount();
+
+		auto fail = [&](auto const&... parts) {
+			(out << ... << parts);
+			problem = out.str();
+			return false;
+		};
+
+		if (index.size() != nNodes || offsets.size() != nNodes + 1 || rOffsets.size() != nNodes + 1 || places.xs.size() != nNodes || places.ys.size() != nNodes)
+			return fail("the node arrays disagree on the number of places");
+
+		if (sources.size() != nEdges || distances.size() != nEdges || fees.size() != nEdges || vehicles.size() != nEdges || rEdges.size() != nEdges)
+			return fail("the edge arrays disagree on the number of connections");
+
+		if (landmarks.fromLandmark.size() != nNodes * landmarks.size() || landmarks.toLandmark.size() != nNodes * landmarks.size())
+			return fail("the landmark tables do not match the number of places and landmarks");
+
+		for (size_t k = 0; k < landmarks.size(); ++k)
+		{
+			if (landmarks.landmarks[k] >= nNodes || landmarks.from(static_cast<uint32_t>(k), landmarks.landmarks[k]) != 0.0)
+				return fail("landmark ", k, " is not a place at distance 0 from itself");
+		}
+
+		for (size_t i = 0; i < nNodes; ++i)
+		{
+			if (index[i].node >= nNodes || ids[index[i].node] != index[i].place)
+				return fail("index entry ", i, " does not point back at place ", index[i].place);
+			if (i > 0 && !(index[i - 1].place < index[i].place))
+				return fail("the place index is not strictly sorted at entry ", i);
+		}
+
+		if (offsets[0] != 0 || offsets[nNodes] != nEdges || rOffsets[0] != 0 || rOffsets[nNodes] != nEdges)
+			return fail("the offsets do not span the edge arrays");
+
+		for (uint32_t node = 0; node < nNodes; ++node)
+		{
+			if (offsets[node] > offsets[node + 1] || rOffsets[node] > rOffsets[node + 1])
+				return fail("the offsets of place ", ids[node], " go backwards");
+
+			for (uint32_t edge = edgesBegin(node); edge < edgesEnd(node); ++edge)
+			{
+				if (sources[edge] != node || targets[edge] >= nNodes)
+					return fail("connection ", edge, " has a bad source or target");
+				if (vehicles[edge] != PLANE && vehicles[edge] != SHIP && vehicles[edge] != CAR)
+					return fail("connection ", edge, " has an unknown vehicle type");
+				if (edge > edgesBegin(node) && std::tie(targets[edge], distances[edge]) < std::tie(targets[edge - 1], distances[edge - 1]))
+					return fail("the connections of place ", ids[node], " are not sorted");
+			}
+
+			for (uint32_t i = inBegin(node); i < inEnd(node); ++i)
+			{
+				if (rEdges[i] >= nEdges || targets[rEdges[i]] != node)
+					return fail("the reverse adjacency of place ", ids[node], " lists a foreign connection");
+			}
+		}
+
+		return true;
+	}
+
+	bool GraphSnapshot::sameAs(GraphSnapshot const& other) const
+	{
+		auto same = [](auto const& l, auto const& r) {
+			return l.size() == r.size() && std::memcmp(l.data(), r.data(), l.size() * sizeof(*l.data())) == 0;
+		};
+
+		return same(index, other.index) && same(ids, other.ids) && same(offsets, other.offsets) && same(sources, other.sources)
+			&& same(targets, other.targets) && same(distances, other.distances) && same(fees, other.fees) && same(vehicles, other.vehicles)
+			&& same(rOffsets, other.rOffsets) && same(rEdges, other.rEdges) && same(places.xs, other.places.xs) && same(places.ys, other.places.ys);
+	}
+
+	void GraphSnapshot::clear()
+	{
+		index.clear();
+		ids.clear();
+		offsets.clear();
+		sources.clear();
+		targets.clear();
+		distances.clear();
+		fees.clear();
+		vehicles.clear();
+		rOffsets.clear();
+		rEdges.clear();
+		places.clear();
+		landmarks.clear();
+		mapping.close();
+		loaded = false;
+	}
+}
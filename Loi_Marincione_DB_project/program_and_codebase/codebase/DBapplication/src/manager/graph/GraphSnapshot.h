@@ -0,0 +1,230 @@
+#pragma once
+#include "libpq-fe.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "PathTypes.h"
+#include "PlaceTable.h"
+#include "LandmarkTable.h"
+#include "Column.h"
+#include "MappedFile.h"
+
+
+namespace paths
+{
+	/**
+	 * One changed row of "Connection", as sent by the connection_delta trigger.
+	 * An update arrives as the removal of the old row followed by the insertion of the new one.
+	 */
+	struct edgeDelta
+	{
+		int64_t version;
+		bool removed;
+		int64_t from;
+		int64_t to;
+		VehicleType vehicle;
+		double fee = 0.0;
+		double distance = 0.0;
+	};
+
+	/**
+	 * Reads the "ConnectionVersion" sequence, the version of "Connection" graphs are stamped with (0 if it never moved).
+	 *
+	 * \return  False if the sequence does not exist.
+	 */
+	bool readConnectionVersion(PGconn* const& conn, int64_t& version);
+
+	/**
+	 * Rows the snapshot is built from, when they do not come straight from the DB (a CSV dump).
+	 */
+	struct placeRow
+	{
+		int64_t id;
+		double x;
+		double y;
+	};
+
+	struct connectionRow
+	{
+		int64_t from;
+		int64_t to;
+		VehicleType vehicle;
+		double fee;
+		double distance;
+	};
+
+	/**
+	 * Entry of the Place ID -> dense index map, kept as an array sorted by place so it can be stored and mapped.
+	 */
+	struct placeIndex
+	{
+		int64_t place;
+		uint32_t node;
+		uint32_t unused;
+	};
+
+	/**
+	 * A read-only, in-memory copy of the "Connection" table laid out in CSR (compressed sparse row) form.
+	 *
+	 * Every "Place" is renumbered into a dense index [0, nodeCount()), the outgoing edges of node n are
+	 * the range [offsets[n], offsets[n + 1]) of the edge arrays. Edges of a node are sorted by
+	 * (target, distance), so the first edge towards a given target is always the shortest one.
+	 * A reverse CSR over the same edge IDs lists the incoming edges of every node, for backward searches.
+	 *
+	 * The arrays are Columns: filled from the DB they own their memory, opened from a snapshot file
+	 * (see SnapshotFormat.h) they point straight into the mapped file and nothing is deserialised.
+	 */
+	class GraphSnapshot
+	{
+	public:
+		static constexpr uint32_t NO_NODE = UINT32_MAX;
+		static constexpr uint32_t NO_EDGE = UINT32_MAX;
+
+		/**
+		 * Loads the "Place" coordinates and the whole "Connection" table, one query each, replacing the current contents.
+		 *
+		 * \param conn  Pointer to a Database Connection.
+		 * \return      True if the table was fetched and the snapshot is usable.
+		 */
+		bool load(PGconn* const& conn);
+
+		/**
+		 * Builds the snapshot from rows read elsewhere, the same way load() does.
+		 */
+		void assign(std::vector<placeRow> const& place_rows, std::vector<connectionRow> const& connection_rows);
+
+		/**
+		 * Maps a snapshot file written by save() and uses it in place, replacing the current contents.
+		 * Only the header and the section bounds are checked unless verify_checksum is set, which reads the whole file.
+		 *
+		 * \param path             The snapshot file.
+		 * \param version          Receives the "ConnectionVersion" the file was written at.
+		 * \param verify_checksum  Also hash the file against the checksum in its header.
+		 * \return                 False if the file is missing, of another format or damaged, the snapshot is empty then.
+		 */
+		bool map(std::string const& path, int64_t& version, bool verify_checksum=false);
+
+		/**
+		 * Writes the snapshot to path, through a temporary file renamed over it so readers never see half a file.
+		 *
+		 * \param version  The "ConnectionVersion" the contents correspond to.
+		 */
+		bool save(std::string const& path, int64_t version) const;
+
+		/**
+		 * Checks the invariants of the CSR arrays, the searches trust them blindly.
+		 *
+		 * \param problem  Receives a description of the first broken invariant.
+		 */
+		bool validate(std::string& problem) const;
+
+		/**
+		 * True if both snapshots hold the very same graph, landmarks aside (they are derived from it).
+		 */
+		bool sameAs(GraphSnapshot const& other) const;
+
+		/**
+		 * Brings the snapshot up to date with a run of row changes, in commit order, without going back to the DB.
+		 * "Connection" is keyed by (PlaceA, PlaceB, AllowedVehicles), so an insertion replaces the edge with the
+		 * same key and a removal of a missing edge does nothing: replaying changes the snapshot already holds is harmless.
+		 *
+		 * The edge arrays are rebuilt in one pass (the untouched edges are already in order, only the inserted ones
+		 * get sorted), so edge IDs change but node indices stay, and searches keep running on plain CSR arrays.
+		 * The landmarks are dropped only if an inserted connection shortens one of their distances.
+		 *
+		 * \return  False if an inserted edge touches a place the snapshot does not know, which needs a full load.
+		 */
+		bool apply(std::vector<edgeDelta> const& deltas);
+
+		/**
+		 * Chooses count landmarks and computes their distance tables, replacing the current ones.
+		 */
+		void placeLandmarks(size_t count) { landmarks.build(*this, count); }
+
+		void clear();
+
+		bool isLoaded() const { return loaded; }
+		bool isMapped() const { return mapping.isOpen(); }
+
+		uint32_t indexOf(int64_t place) const;
+
+		/**
+		 * The connection from -> to of the given vehicle, NO_EDGE if there is none.
+		 */
+		uint32_t findEdge(uint32_t from, uint32_t to, VehicleType vehicle) const
+		{
+			for (uint32_t edge = edgesBegin(from); edge < edgesEnd(from); ++edge)
+			{
+				if (targets[edge] == to && vehicle == this->vehicle(edge))
+					return edge;
+			}
+			return NO_EDGE;
+		}
+
+		int64_t placeOf(uint32_t node) const { return ids[node]; }
+
+		size_t nodeCount() const { return ids.size(); }
+		size_t edgeCount() const { return targets.size(); }
+
+		uint32_t edgesBegin(uint32_t node) const { return offsets[node]; }
+		uint32_t edgesEnd(uint32_t node) const { return offsets[node + 1]; }
+
+		uint32_t inBegin(uint32_t node) const { return rOffsets[node]; }
+		uint32_t inEnd(uint32_t node) const { return rOffsets[node + 1]; }
+		uint32_t inEdge(uint32_t i) const { return rEdges[i]; }
+
+		uint32_t source(uint32_t edge) const { return sources[edge]; }
+		uint32_t target(uint32_t edge) const { return targets[edge]; }
+		double distance(uint32_t edge) const { return distances[edge]; }
+		double fee(uint32_t edge) const { return fees[edge]; }
+		VehicleType vehicle(uint32_t edge) const { return static_cast<VehicleType>(vehicles[edge]); }
+
+		PlaceTable const& getPlaces() const { return places; }
+		LandmarkTable const& getLandmarks() const { return landmarks; }
+
+		/**
+		 * Turns a chain of edge IDs into path legs, with cumulative distances like the A* frontier.
+		 */
+		void toLegs(std::vector<uint32_t> const& edges, std::vector<destination>& path) const
+		{
+			double travelled = path.empty() ? 0.0 : path.back().distance;
+			for (auto const edge : edges)
+			{
+				travelled += distances[edge];
+				path.emplace_back(vehicle(edge), ids[sources[edge]], ids[targets[edge]], travelled, fees[edge], 0.0);
+			}
+		}
+
+	private:
+		struct rawEdge;
+
+		/**
+		 * Fills the forward and reverse CSR from a list of edges sorted by (from, to, distance, vehicle, fee).
+		 */
+		void build(std::vector<rawEdge> const& edges);
+
+		/**
+		 * Copies every array out of the mapped file and unmaps it, before the arrays get modified.
+		 */
+		void detach();
+
+		Column<placeIndex> index;					// sorted by Place ID
+		Column<int64_t> ids;						// dense index -> Place ID
+
+		Column<uint32_t> offsets;					// nodeCount() + 1 entries
+		Column<uint32_t> sources;
+		Column<uint32_t> targets;
+		Column<double> distances;
+		Column<double> fees;
+		Column<uint8_t> vehicles;					// VehicleType, one byte each
+
+		Column<uint32_t> rOffsets;					// nodeCount() + 1 entries
+		Column<uint32_t> rEdges;					// edge IDs grouped by target
+
+		PlaceTable places;
+		LandmarkTable landmarks;
+		MappedFile mapping;							// open while the arrays borrow from a snapshot file
+
+		bool loaded = false;
+	};
+}
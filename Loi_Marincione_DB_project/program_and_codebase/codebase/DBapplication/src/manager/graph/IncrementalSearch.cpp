@@ -0,0 +1,146 @@
+#include "IncrementalSearch.h"
+
+
+namespace paths
+{
+	void IncrementalSearch::start(GraphSnapshot const& graph, uint32_t source, uint32_t goal, char allowed_vehicles)
+	{
+		states.clear();
+		open = {};
+
+		this->source = source;
+		this->goal = goal;
+		allowed = allowed_vehicles & ALL_VEHICLES;
+		started = true;
+
+		// The source is the only place whose rhs is not derived from its predecessors
+		states[source].rhs = 0.0;
+		open.push({ keyOf(graph, source, states[source]), source });
+	}
+
+	void IncrementalSearch::connectionChanged(GraphSnapshot const& graph, VehicleLayer const& layer, uint32_t from, uint32_t to)
+	{
+		// Only the costs leading into to can change, and only through it the rest of the tree
+		if (started && from != to)
+			updateVertex(graph, layer, to);
+	}
+
+	void IncrementalSearch::updateVertex(GraphSnapshot const& graph, VehicleLayer const& layer, uint32_t node)
+	{
+		if (node == source)
+			return;
+
+		double rhs = INF;
+		for (uint32_t i = layer.inBegin(node); i < layer.inEnd(node); ++i)
+		{
+			uint32_t const edge = layer.inEdge(i);
+			double const g = stateOf(graph.source(edge)).g;
+			if (g < INF)
+				rhs = std::min(rhs, g + graph.distance(edge));
+		}
+
+		auto it = states.find(node);
+		if (it == states.end())
+		{
+			// Never reached and still unreachable, nothing to keep
+			if (rhs == INF)
+				return;
+			it = states.emplace(node, nodeState{}).first;
+		}
+
+		it->second.rhs = rhs;
+		if (it->second.g != it->second.rhs)
+			open.push({ keyOf(graph, node, it->second), node });
+	}
+
+	bool IncrementalSearch::isStale(GraphSnapshot const& graph, queued const& entry) const
+	{
+		nodeState const state = stateOf(entry.node);
+		return state.g == state.rhs || entry.k != keyOf(graph, entry.node, state);
+	}
+
+	searchResult IncrementalSearch::compute(GraphSnapshot const& graph, VehicleLayer const& layer)
+	{
+		searchResult result;
+		if (!started)
+			return result;
+
+		for (;;)
+		{
+			while (!open.empty() && isStale(graph, open.top()))
+				open.pop();
+
+			nodeState const target = stateOf(goal);
+			if (open.empty() || (!(open.top().k < keyOf(graph, goal, target)) && target.g == target.rhs))
+				break;
+
+			uint32_t const u = open.top().node;
+			open.pop();
+			++result.expanded;
+
+			nodeState& state = states[u];
+			if (state.g > state.rhs)
+			{
+				state.g = state.rhs;
+			}
+			else
+			{
+				// Underconsistent: its cost went up, it and everything that went through it are looked at again
+				state.g = INF;
+				updateVertex(graph, layer, u);
+			}
+
+			// Parallel connections are next to each other (edges are sorted by target, layers keep the order), one update is enough
+			uint32_t last = GraphSnapshot::NO_NODE;
+			for (uint32_t i = layer.outBegin(u); i < layer.outEnd(u); ++i)
+			{
+				uint32_t const v = graph.target(layer.outEdge(i));
+				if (v != last)
+					updateVertex(graph, layer, v);
+				last = v;
+			}
+		}
+
+		double const cost = stateOf(goal).g;
+		if (cost == INF)
+			return result;
+
+		/*
+
+		Walking back from the goal through the predecessor each cost came from
+
+		*/
+		std::vector<uint32_t> edges;
+		uint32_t node = goal;
+		for (size_t steps = 0; node != source; ++steps)
+		{
+			if (steps == graph.nodeCount())
+				return result;
+
+			uint32_t best = GraphSnapshot::NO_EDGE;
+			double bestCost = INF;
+			for (uint32_t i = layer.inBegin(node); i < layer.inEnd(node); ++i)
+			{
+				uint32_t const edge = layer.inEdge(i);
+				double const g = stateOf(graph.source(edge)).g + graph.distance(edge);
+				if (g < bestCost)
+				{
+					bestCost = g;
+					best = edge;
+				}
+			}
+
+			if (best == GraphSnapshot::NO_EDGE)
+				return result;
+
+			edges.push_back(best);
+			node = graph.source(best);
+		}
+
+		std::reverse(edges.begin(), edges.end());
+		graph.toLegs(edges, result.path);
+		result.cost = cost;
+		result.found = true;
+		return result;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "PathTypes.h"
+#include "GraphSnapshot.h"
+#include "VehicleLayer.h"
+
+
+namespace paths
+{
+	/**
+	 * Lifelong Planning A* (LPA*) between two fixed places, on travelled distance over the connections of a
+	 * VehicleLayer. The layer is passed on every call, it may be rebuilt in between as long as its vehicles stay.
+	 *
+	 * The search keeps, for every place it touched, its cost g and the one-step lookahead rhs (the best
+	 * g of a predecessor plus the connection from it). After the graph changed, only the places at the
+	 * far end of a changed connection are told (connectionChanged()) and compute() expands again just the
+	 * places whose cost actually moved, instead of searching the whole route from scratch.
+	 *
+	 * The state is sparse, a route only costs memory for the places its searches reached, and it relies on
+	 * node indices staying put: GraphSnapshot::apply() keeps them, a full load or a new snapshot does not,
+	 * so searches have to be started again after one. The heuristic is the straight line, which the
+	 * connection changes cannot invalidate (landmark tables can, see GraphSnapshot::apply()).
+	 */
+	class IncrementalSearch
+	{
+	public:
+		static constexpr double INF = std::numeric_limits<double>::infinity();
+
+		/**
+		 * Forgets everything and sets up a search from source to goal on the given vehicles, the first compute() is a plain A*.
+		 */
+		void start(GraphSnapshot const& graph, uint32_t source, uint32_t goal, char allowed_vehicles);
+
+		/**
+		 * Tells the search that the connections from -> to changed (inserted, removed, new distance).
+		 * Changes can pile up, they are all repaired by the next compute().
+		 */
+		void connectionChanged(GraphSnapshot const& graph, VehicleLayer const& layer, uint32_t from, uint32_t to);
+
+		/**
+		 * Brings the costs up to date with the changes received and extracts the shortest route.
+		 *
+		 * \return  The route (cost is its distance), expanded counts only the places expanded by this call.
+		 */
+		searchResult compute(GraphSnapshot const& graph, VehicleLayer const& layer);
+
+		bool isStarted() const { return started; }
+		uint32_t getSource() const { return source; }
+		uint32_t getGoal() const { return goal; }
+		char getAllowedVehicles() const { return allowed; }
+
+		// Places the search holds a cost for
+		size_t stateSize() const { return states.size(); }
+
+	private:
+		struct nodeState
+		{
+			double g = INF;
+			double rhs = INF;
+		};
+
+		using key = std::pair<double, double>;
+
+		struct queued
+		{
+			key k;
+			uint32_t node;
+
+			bool operator>(queued const& other) const { return k > other.k; }
+		};
+
+		nodeState stateOf(uint32_t node) const
+		{
+			auto it = states.find(node);
+			return it == states.end() ? nodeState{} : it->second;
+		}
+
+		key keyOf(GraphSnapshot const& graph, uint32_t node, nodeState const& state) const
+		{
+			double const best = std::min(state.g, state.rhs);
+			return { best + graph.getPlaces().distance(node, goal), best };
+		}
+
+		/**
+		 * Recomputes rhs of node from its incoming connections in the layer and queues it if it became inconsistent.
+		 */
+		void updateVertex(GraphSnapshot const& graph, VehicleLayer const& layer, uint32_t node);
+
+		/**
+		 * True if the entry no longer stands for an inconsistent place with that key (the heap is lazy,
+		 * a place is queued again instead of being moved, and the old entries are skipped when they surface).
+		 */
+		bool isStale(GraphSnapshot const& graph, queued const& entry) const;
+
+		std::unordered_map<uint32_t, nodeState> states;
+		std::priority_queue<queued, std::vector<queued>, std::greater<queued>> open;
+
+		uint32_t source = GraphSnapshot::NO_NODE;
+		uint32_t goal = GraphSnapshot::NO_NODE;
+		char allowed = ALL_VEHICLES;
+		bool started = false;
+	};
+}
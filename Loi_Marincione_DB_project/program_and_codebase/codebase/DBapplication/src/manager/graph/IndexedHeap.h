@@ -0,0 +1,184 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace paths
+{
+	/**
+	 * Min-heap of graph nodes with a d-ary layout and decrease-key. Every node is in the heap at most once,
+	 * its slot is tracked in a position array addressed by the node index, so lowering a key moves the
+	 * existing entry instead of pushing a duplicate.
+	 *
+	 * A wider node (Arity 4 by default) makes the tree shallower, which helps the decrease-key heavy
+	 * searches on road-like graphs at the cost of more comparisons per pop.
+	 */
+	template<unsigned Arity = 4>
+	class IndexedHeap
+	{
+		static_assert(Arity >= 2, "A heap needs at least two children per node");
+
+	public:
+		static constexpr uint32_t NOT_IN_HEAP = UINT32_MAX;
+
+		using entry = std::pair<double, uint32_t>;	// key, node
+
+		/**
+		 * Operation counters, reset together with the heap.
+		 */
+		struct counters
+		{
+			size_t pushes = 0;
+			size_t decreases = 0;
+			size_t pops = 0;
+		};
+
+		/**
+		 * Empties the heap, resizing the position array if the graph changed size.
+		 */
+		void reset(size_t nodes)
+		{
+			if (positions.size() != nodes)
+			{
+				positions.assign(nodes, NOT_IN_HEAP);
+			}
+			else
+			{
+				for (auto const& queued : heap)
+					positions[queued.second] = NOT_IN_HEAP;
+			}
+
+			heap.clear();
+			stats = counters();
+		}
+
+		bool empty() const { return heap.empty(); }
+		size_t size() const { return heap.size(); }
+		entry const& top() const { return heap.front(); }
+		bool contains(uint32_t node) const { return positions[node] != NOT_IN_HEAP; }
+		counters const& getCounters() const { return stats; }
+
+		/**
+		 * Inserts node with the given key or lowers the key it already has, a higher key is ignored.
+		 *
+		 * \return  True if the heap changed.
+		 */
+		bool push(double key, uint32_t node)
+		{
+			uint32_t slot = positions[node];
+
+			if (slot == NOT_IN_HEAP)
+			{
+				slot = static_cast<uint32_t>(heap.size());
+				heap.emplace_back(key, node);
+				positions[node] = slot;
+				++stats.pushes;
+			}
+			else if (key < heap[slot].first)
+			{
+				heap[slot].first = key;
+				++stats.decreases;
+			}
+			else
+			{
+				return false;
+			}
+
+			siftUp(slot);
+			return true;
+		}
+
+		entry pop()
+		{
+			entry top = heap.front();
+			positions[top.second] = NOT_IN_HEAP;
+			++stats.pops;
+
+			entry last = heap.back();
+			heap.pop_back();
+
+			if (!heap.empty())
+			{
+				heap.front() = last;
+				positions[last.second] = 0;
+				siftDown(0);
+			}
+
+			return top;
+		}
+
+		/**
+		 * Gives every queued node the key key_of(node) returns and restores the heap order in one
+		 * bottom-up pass, cheaper than popping and pushing everything when all the keys change at once.
+		 */
+		template<class KeyOf>
+		void rekey(KeyOf&& key_of)
+		{
+			for (auto& queued : heap)
+				queued.first = key_of(queued.second);
+
+			// Only the inner slots can be out of order, the last one is the parent of the last entry
+			for (size_t slot = (heap.size() < 2) ? 0 : (heap.size() - 2) / Arity + 1; slot-- > 0;)
+				siftDown(slot);
+		}
+
+	private:
+		void place(size_t slot, entry const& value)
+		{
+			heap[slot] = value;
+			positions[value.second] = static_cast<uint32_t>(slot);
+		}
+
+		void siftUp(size_t slot)
+		{
+			entry moving = heap[slot];
+
+			while (slot > 0)
+			{
+				size_t parent = (slot - 1) / Arity;
+				if (!(moving.first < heap[parent].first))
+					break;
+
+				place(slot, heap[parent]);
+				slot = parent;
+			}
+
+			place(slot, moving);
+		}
+
+		void siftDown(size_t slot)
+		{
+			entry moving = heap[slot];
+			size_t const count = heap.size();
+
+			for (;;)
+			{
+				size_t first = slot * Arity + 1;
+				if (first >= count)
+					break;
+
+				size_t last = (first + Arity < count) ? first + Arity : count;
+				size_t best = first;
+				for (size_t child = first + 1; child < last; ++child)
+				{
+					if (heap[child].first < heap[best].first)
+						best = child;
+				}
+
+				if (!(heap[best].first < moving.first))
+					break;
+
+				place(slot, heap[best]);
+				slot = best;
+			}
+
+			place(slot, moving);
+		}
+
+		std::vector<entry> heap;
+		std::vector<uint32_t> positions;
+		counters stats;
+	};
+}
@@ -0,0 +1,139 @@
+#include "LandmarkTable.h"
+#include "GraphSnapshot.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+
+namespace paths
+{
+	namespace
+	{
+		constexpr double INF = std::numeric_limits<double>::infinity();
+
+		using entry = std::pair<double, uint32_t>;
+		using minheap = std::priority_queue<entry, std::vector<entry>, std::greater<entry>>;
+
+		/**
+		 * Plain Dijkstra over every connection, forward from origin or, with backward set, towards it.
+		 */
+		void distancesOf(GraphSnapshot const& graph, uint32_t origin, bool backward, std::vector<double>& dist)
+		{
+			dist.assign(graph.nodeCount(), INF);
+			dist[origin] = 0.0;
+
+			minheap heap;
+			heap.emplace(0.0, origin);
+
+			while (!heap.empty())
+			{
+				auto [d, u] = heap.top();
+				heap.pop();
+
+				if (d > dist[u]) continue;
+
+				uint32_t const begin = backward ? graph.inBegin(u) : graph.edgesBegin(u);
+				uint32_t const end = backward ? graph.inEnd(u) : graph.edgesEnd(u);
+
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					uint32_t edge = backward ? graph.inEdge(i) : i;
+					uint32_t v = backward ? graph.source(edge) : graph.target(edge);
+					double nd = d + graph.distance(edge);
+
+					if (nd < dist[v])
+					{
+						dist[v] = nd;
+						heap.emplace(nd, v);
+					}
+				}
+			}
+		}
+	}
+
+	void LandmarkTable::build(GraphSnapshot const& graph, size_t count)
+	{
+		clear();
+
+		size_t const nNodes = graph.nodeCount();
+		count = std::min(count, nNodes);
+
+		if (count == 0)
+			return;
+
+		std::vector<uint32_t> chosen;
+		std::vector<double> from_table(nNodes * count, INF);
+		std::vector<double> to_table(nNodes * count, INF);
+
+		std::vector<double> forward;
+		std::vector<double> backward;
+
+		// Seeded from the best connected place, which surely lies in the main part of the network
+		uint32_t seed = 0;
+		for (uint32_t v = 1; v < nNodes; ++v)
+		{
+			if (graph.edgesEnd(v) - graph.edgesBegin(v) > graph.edgesEnd(seed) - graph.edgesBegin(seed))
+				seed = v;
+		}
+
+		// How far every place is from the landmarks chosen so far (from the seed before the first one)
+		std::vector<double> spread;
+		distancesOf(graph, seed, false, spread);
+
+		while (chosen.size() < count)
+		{
+			// Places without a finite distance would make useless landmarks, the network cannot reach them
+			uint32_t landmark = GraphSnapshot::NO_NODE;
+			double farthest = 0.0;
+			for (uint32_t v = 0; v < nNodes; ++v)
+			{
+				if (spread[v] != INF && spread[v] > farthest)
+				{
+					farthest = spread[v];
+					landmark = v;
+				}
+			}
+
+			if (landmark == GraphSnapshot::NO_NODE)
+			{
+				if (!chosen.empty())
+					break;
+				landmark = seed;
+			}
+
+			size_t const k = chosen.size();
+			chosen.push_back(landmark);
+
+			distancesOf(graph, landmark, false, forward);
+			distancesOf(graph, landmark, true, backward);
+
+			for (uint32_t v = 0; v < nNodes; ++v)
+			{
+				from_table[v * count + k] = forward[v];
+				to_table[v * count + k] = backward[v];
+
+				// Round trip to the closest landmark
+				double round_trip = forward[v] + backward[v];
+				spread[v] = (k == 0) ? round_trip : std::min(spread[v], round_trip);
+			}
+		}
+
+		// Fewer landmarks than asked for: squeeze the unused columns out
+		if (chosen.size() < count)
+		{
+			size_t const used = chosen.size();
+			for (size_t v = 0; v < nNodes; ++v)
+			{
+				std::copy_n(from_table.begin() + v * count, used, from_table.begin() + v * used);
+				std::copy_n(to_table.begin() + v * count, used, to_table.begin() + v * used);
+			}
+			from_table.resize(nNodes * used);
+			to_table.resize(nNodes * used);
+		}
+
+		landmarks.assign(std::move(chosen));
+		fromLandmark.assign(std::move(from_table));
+		toLandmark.assign(std::move(to_table));
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "Column.h"
+
+
+namespace paths
+{
+	class GraphSnapshot;
+
+	/**
+	 * Distance tables of the ALT heuristic (A*, Landmarks, Triangle inequality): for a handful of landmark
+	 * places, the shortest distance from every place to each landmark and from each landmark to every place.
+	 *
+	 * For any landmark L the triangle inequality gives d(v, t) >= d(L, t) - d(L, v) and d(v, t) >= d(v, L) - d(t, L),
+	 * a far tighter bound than the straight line on a network full of detours. Distances are over every
+	 * connection whatever its vehicle, so the bounds hold for any vehicle layer and, every cost policy
+	 * pricing a connection at least at its distance, for any policy too.
+	 *
+	 * The tables are node-major (the K values of a place are contiguous) and stored in the snapshot file
+	 * next to the graph, like PlaceTable; unreachable pairs hold infinity.
+	 */
+	struct LandmarkTable
+	{
+		// Enough to bound most queries well, at 16 bytes per place and landmark
+		static constexpr size_t DEFAULT_COUNT = 16;
+
+		Column<uint32_t> landmarks;		// dense node index of every landmark
+		Column<double> fromLandmark;	// [v * size() + k]: d(landmark k, v)
+		Column<double> toLandmark;		// [v * size() + k]: d(v, landmark k)
+
+		size_t size() const { return landmarks.size(); }
+
+		void clear() { landmarks.clear(); fromLandmark.clear(); toLandmark.clear(); }
+
+		size_t memoryBytes() const { return landmarks.size() * sizeof(uint32_t) + (fromLandmark.size() + toLandmark.size()) * sizeof(double); }
+
+		/**
+		 * Picks up to count landmarks by farthest selection and fills the tables, one Dijkstra each way per landmark.
+		 * Every new landmark is the place with the longest round trip to the closest landmark already chosen,
+		 * so landmarks spread towards the borders of the network, where their bounds are the tightest.
+		 */
+		void build(GraphSnapshot const& graph, size_t count);
+
+		/**
+		 * True if a connection from -> to of the given length shortens no landmark distance: the tables are then
+		 * still exact once it is added. Removing connections only makes distances longer, the tables stay lower bounds.
+		 */
+		bool keepsExact(uint32_t from_node, uint32_t to_node, double length) const
+		{
+			for (uint32_t k = 0; k < size(); ++k)
+			{
+				if (from(k, from_node) + length < from(k, to_node) || to(k, to_node) + length < to(k, from_node))
+					return false;
+			}
+			return true;
+		}
+
+		double from(uint32_t landmark, uint32_t node) const { return fromLandmark[node * size() + landmark]; }
+		double to(uint32_t landmark, uint32_t node) const { return toLandmark[node * size() + landmark]; }
+	};
+}
@@ -0,0 +1,55 @@
+#include "MappedFile.h"
+#include <Windows.h>
+
+
+namespace paths
+{
+	bool MappedFile::open(std::string const& path)
+	{
+		close();
+
+		HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+			return false;
+		file = handle;
+
+		LARGE_INTEGER length;
+		if (!GetFileSizeEx(handle, &length) || length.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (view == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		bytes = static_cast<size_t>(length.QuadPart);
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if (view != nullptr)
+			UnmapViewOfFile(view);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		if (file != nullptr)
+			CloseHandle(file);
+
+		file = nullptr;
+		mapping = nullptr;
+		view = nullptr;
+		bytes = 0;
+	}
+}
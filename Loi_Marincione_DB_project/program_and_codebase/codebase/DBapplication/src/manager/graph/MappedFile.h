@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace paths
+{
+	/**
+	 * A whole file mapped read-only into memory, unmapped when the object goes away.
+	 * Pages are only read from disk once they are touched.
+	 */
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile() { close(); }
+
+		MappedFile(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile const&) = delete;
+
+		/**
+		 * Maps path, replacing the current mapping.
+		 *
+		 * \return  False if the file does not exist, is empty or cannot be mapped.
+		 */
+		bool open(std::string const& path);
+		void close();
+
+		bool isOpen() const { return view != nullptr; }
+		uint8_t const* data() const { return static_cast<uint8_t const*>(view); }
+		size_t size() const { return bytes; }
+
+	private:
+		void* file = nullptr;
+		void* mapping = nullptr;
+		void const* view = nullptr;
+		size_t bytes = 0;
+	};
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+namespace paths
+{
+	enum VehicleType : char
+	{
+		PLANE = 1,
+		SHIP = 2,
+		CAR = 4
+	};
+
+	enum class SearchMode : char
+	{
+		UNIDIRECTIONAL,
+		BIDIRECTIONAL,
+		CONTRACTION_HIERARCHY,
+		PARETO,
+		ANYTIME,
+		ALTERNATIVES
+	};
+
+	constexpr char ALL_VEHICLES = PLANE | SHIP | CAR;
+
+	/**
+	 * Options every search mode honours. allowedVehicles is a mask of VehicleType bits, connections
+	 * of any other vehicle are left out of the search altogether (see VehicleLayer).
+	 * alternatives is how many routes the ALTERNATIVES mode lists at most.
+	 */
+	struct pathOptions
+	{
+
+		char allowedVehicles = ALL_VEHICLES;
+		unsigned alternatives = 5;
+
+	};
+
+	struct destination
+	{
+		VehicleType vehicle;
+		int64_t from;
+		int64_t to;
+		double distance;
+		double fee;
+		double heuristic;
+
+	public:
+		inline destination(paths::VehicleType const vehicleType, int64_t const from_code, int64_t const to_code, double const distance_val, double const fee, double const heuristic) 
+			: vehicle(vehicleType), from(from_code), to(to_code), distance(distance_val), fee(fee), heuristic(heuristic) {}
+		destination(destination const& other) = default;
+	};
+
+	/**
+	 * Outcome of a single search: the legs of the path (distances are cumulative, like on the frontier),
+	 * its total cost under the cost policy used and the number of nodes taken off the frontier(s) to find it.
+	 * reconstructionMs is the part of the search spent turning the parents into legs, where it is measured.
+	 */
+	struct searchResult
+	{
+		std::vector<destination> path;
+		double cost = 0.0;
+		size_t expanded = 0;
+		bool found = false;
+		double reconstructionMs = 0.0;
+	};
+
+	/**
+	 * One entry of a batch of routes to plan, special_case and options have the same meaning as in Pathfinder::pathfind.
+	 */
+	struct routeRequest
+	{
+		int64_t from;
+		int64_t to;
+		int64_t client;
+		short specialCase = 0;
+		pathOptions options;
+	};
+
+	/**
+	 * One route of a Pareto front: no other route found is at least as good on distance, total fee
+	 * and number of vehicle changes while being strictly better on one of them.
+	 */
+	struct paretoRoute
+	{
+		std::vector<destination> path;
+		double distance = 0.0;
+		double fee = 0.0;
+		uint32_t modeChanges = 0;
+	};
+
+	/**
+	 * A stored "Route" that went through a connection changed since the last replan, or one that no longer exists.
+	 * Costs are travelled distances: previousCost is the stored route before the changes, currentCost the same
+	 * legs now (infinite if one of them is gone) and repaired the shortest route now, on the vehicles the stored legs use.
+	 */
+	struct routeRepair
+	{
+		int64_t route;
+		std::vector<int64_t> shipments;		// non-historical shipments travelling the route
+		double previousCost = 0.0;
+		double currentCost = 0.0;
+		searchResult repaired;
+	};
+
+	/**
+	 * Maps the textual value of a "VehicleType" enum column onto its VehicleType bit.
+	 */
+	inline VehicleType toVehicle(std::string_view vCode)
+	{
+		return (vCode == "Car") ? CAR : ((vCode == "Plane") ? PLANE : SHIP);
+	}
+}
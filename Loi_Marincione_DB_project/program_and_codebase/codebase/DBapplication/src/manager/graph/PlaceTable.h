@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include "Column.h"
+
+
+namespace paths
+{
+	/**
+	 * Coordinates of every "Place", stored as two parallel arrays addressed by the dense node index
+	 * of the GraphSnapshot that owns the table.
+	 */
+	struct PlaceTable
+	{
+		Column<double> xs;
+		Column<double> ys;
+
+		void clear() { xs.clear(); ys.clear(); }
+
+		double distance(uint32_t a, uint32_t b) const
+		{
+			double dx = xs[a] - xs[b];
+			double dy = ys[a] - ys[b];
+			return std::sqrt(dx * dx + dy * dy);
+		}
+
+		/**
+		 * Euclidean distance of a batch of nodes from a goal node, the same metric as "distance_points" on the DB.
+		 *
+		 * Coordinates are first gathered into contiguous scratch buffers so that the arithmetic runs
+		 * as a plain loop over packed doubles, which the compiler turns into SIMD code.
+		 *
+		 * \param nodes     Dense node indices, n of them.
+		 * \param goal      Dense node index of the goal.
+		 * \param out       Output buffer, receives n distances.
+		 */
+		void distanceBatch(uint32_t const* nodes, size_t n, uint32_t goal, double* out) const
+		{
+			thread_local std::vector<double> dx;
+			thread_local std::vector<double> dy;
+
+			if (dx.size() < n)
+			{
+				dx.resize(n);
+				dy.resize(n);
+			}
+
+			double const gx = xs[goal];
+			double const gy = ys[goal];
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				dx[i] = xs[nodes[i]];
+				dy[i] = ys[nodes[i]];
+			}
+
+			double* __restrict px = dx.data();
+			double* __restrict py = dy.data();
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				double const ddx = px[i] - gx;
+				double const ddy = py[i] - gy;
+				out[i] = std::sqrt(ddx * ddx + ddy * ddy);
+			}
+		}
+	};
+}
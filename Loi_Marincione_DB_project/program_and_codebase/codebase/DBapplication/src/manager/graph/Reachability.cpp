@@ -0,0 +1,60 @@
+#include "Reachability.h"
+
+
+namespace paths
+{
+	size_t Reachability::search(GraphSnapshot const& graph, VehicleLayer const& layer, uint32_t source, ReachMetric metric, double budget,
+		SearchContext& ctx, std::vector<reachablePlace>& places)
+	{
+		places.clear();
+		ctx.reset(graph.nodeCount());
+
+		if (slots.size() != graph.nodeCount())
+			slots.resize(graph.nodeCount());
+
+		bool const byFee = (metric == ReachMetric::FEE);
+
+		ctx.relax(source, 0.0, SearchContext::NO_EDGE);
+		ctx.push(0.0, source);
+
+		while (!ctx.empty())
+		{
+			uint32_t const u = ctx.pop().second;
+			ctx.close(u);
+
+			// The way there is the way to the parent, already listed, plus one connection
+			uint32_t const edge = ctx.parent(u);
+			slots[u] = static_cast<uint32_t>(places.size());
+
+			if (edge == SearchContext::NO_EDGE)
+			{
+				places.push_back({ graph.placeOf(u), 0.0, 0.0, 0, 0 });
+			}
+			else
+			{
+				reachablePlace const& from = places[slots[graph.source(edge)]];
+				places.push_back({ graph.placeOf(u), from.distance + graph.distance(edge), from.fee + graph.fee(edge), from.legs + 1,
+					char(from.vehicles | graph.vehicle(edge)) });
+			}
+
+			// Every parallel connection is looked at: the shortest one is first, but it need not be the cheapest
+			for (uint32_t i = layer.outBegin(u); i < layer.outEnd(u); ++i)
+			{
+				uint32_t const next = layer.outEdge(i);
+				uint32_t const v = graph.target(next);
+
+				if (ctx.closed(v))
+					continue;
+
+				double const g = ctx.cost(u) + (byFee ? graph.fee(next) : graph.distance(next));
+				if (g <= budget && g < ctx.cost(v))
+				{
+					ctx.relax(v, g, next);
+					ctx.push(g, v);
+				}
+			}
+		}
+
+		return places.size();
+	}
+}
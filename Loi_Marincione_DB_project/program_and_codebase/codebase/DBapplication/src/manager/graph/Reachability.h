@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "PathTypes.h"
+#include "GraphSnapshot.h"
+#include "VehicleLayer.h"
+#include "SearchContext.h"
+
+
+namespace paths
+{
+	/**
+	 * What the budget of a reachability query is spent on.
+	 */
+	enum class ReachMetric : char
+	{
+		DISTANCE,
+		FEE
+	};
+
+	/**
+	 * A place within the budget, with the distance and total fee of the cheapest way there under the metric
+	 * of the query, how many connections it takes and which vehicles it uses (VehicleType bits).
+	 */
+	struct reachablePlace
+	{
+		int64_t place;
+		double distance;
+		double fee;
+		uint32_t legs;
+		char vehicles;
+	};
+
+	/**
+	 * Bounded one-to-all search (isochrone): a Dijkstra on the metric that stops at the budget, so it only
+	 * ever touches the places it reports. It runs on a VehicleLayer and a SearchContext, whose stamped arrays
+	 * need no clearing, so a query costs what it reaches whatever the size of the graph.
+	 */
+	class Reachability
+	{
+	public:
+		/**
+		 * Lists every place source reaches within budget, source included, by increasing metric.
+		 *
+		 * \return  The number of places settled.
+		 */
+		size_t search(GraphSnapshot const& graph, VehicleLayer const& layer, uint32_t source, ReachMetric metric, double budget,
+			SearchContext& ctx, std::vector<reachablePlace>& places);
+
+	private:
+		// Position in places of every settled node, only read for parents, which are always settled first
+		std::vector<uint32_t> slots;
+	};
+}
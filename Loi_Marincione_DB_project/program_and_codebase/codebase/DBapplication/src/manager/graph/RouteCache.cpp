@@ -0,0 +1,73 @@
+#include "RouteCache.h"
+
+
+namespace paths
+{
+	size_t routeKeyHash::operator()(routeKey const& key) const
+	{
+		// boost::hash_combine style mixing
+		size_t seed = std::hash<int64_t>()(key.from);
+		auto mix = [&seed](size_t value) { seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2); };
+
+		mix(std::hash<int64_t>()(key.to));
+		mix(std::hash<int64_t>()(key.version));
+		mix(static_cast<size_t>(key.specialCase) << 16 | static_cast<size_t>(key.mode) << 8 | static_cast<unsigned char>(key.allowedVehicles));
+		return seed;
+	}
+
+	size_t RouteCache::footprint(std::vector<destination> const& path)
+	{
+		// list node and index bucket are rough guesses, the legs dominate anyway
+		return sizeof(entry) + 4 * sizeof(void*) + path.size() * sizeof(destination);
+	}
+
+	bool RouteCache::find(routeKey const& key, std::vector<destination>& path)
+	{
+		auto it = index.find(key);
+
+		if (it == index.end())
+		{
+			++misses;
+			return false;
+		}
+
+		entries.splice(entries.begin(), entries, it->second);
+		path = it->second->path;
+		++hits;
+		return true;
+	}
+
+	void RouteCache::insert(routeKey const& key, std::vector<destination> const& path)
+	{
+		size_t const size = footprint(path);
+
+		if (size > budget)
+			return;
+
+		if (auto it = index.find(key); it != index.end())
+		{
+			used -= footprint(it->second->path);
+			entries.erase(it->second);
+			index.erase(it);
+		}
+
+		while (!entries.empty() && used + size > budget)
+		{
+			used -= footprint(entries.back().path);
+			index.erase(entries.back().key);
+			entries.pop_back();
+			++evictions;
+		}
+
+		entries.push_front({ key, path });
+		index.emplace(key, entries.begin());
+		used += size;
+	}
+
+	void RouteCache::clear()
+	{
+		entries.clear();
+		index.clear();
+		used = 0;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "PathTypes.h"
+
+
+namespace paths
+{
+	/**
+	 * Identifies a search: endpoints, options and the version of "Connection" the route was computed on.
+	 * Routes of an older version can never be matched again, they only wait for eviction.
+	 */
+	struct routeKey
+	{
+		int64_t from;
+		int64_t to;
+		int64_t version;
+		short specialCase;
+		SearchMode mode;
+		char allowedVehicles;
+
+		bool operator==(routeKey const& other) const
+		{
+			return from == other.from && to == other.to && version == other.version
+				&& specialCase == other.specialCase && mode == other.mode && allowedVehicles == other.allowedVehicles;
+		}
+	};
+
+	struct routeKeyHash
+	{
+		size_t operator()(routeKey const& key) const;
+	};
+
+	/**
+	 * Least-recently-used cache of found routes, bounded by an estimate of the memory its entries take.
+	 */
+	class RouteCache
+	{
+	public:
+		static constexpr size_t DEFAULT_BUDGET = 8u << 20;
+
+		explicit RouteCache(size_t budget_bytes = DEFAULT_BUDGET) : budget(budget_bytes) {}
+
+		/**
+		 * Copies the cached route for key into path, refreshing its position in the LRU order.
+		 *
+		 * \return  True on a hit.
+		 */
+		bool find(routeKey const& key, std::vector<destination>& path);
+
+		/**
+		 * Stores a route, evicting the least recently used ones until the budget is met again.
+		 * Routes larger than the whole budget are not stored.
+		 */
+		void insert(routeKey const& key, std::vector<destination> const& path);
+
+		void clear();
+
+		size_t getHits() const { return hits; }
+		size_t getMisses() const { return misses; }
+		size_t getEvictions() const { return evictions; }
+		size_t size() const { return entries.size(); }
+		size_t memoryBytes() const { return used; }
+
+	private:
+		struct entry
+		{
+			routeKey key;
+			std::vector<destination> path;
+		};
+
+		static size_t footprint(std::vector<destination> const& path);
+
+		std::list<entry> entries;	// most recently used first
+		std::unordered_map<routeKey, std::list<entry>::iterator, routeKeyHash> index;
+
+		size_t budget;
+		size_t used = 0;
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+	};
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "PathTypes.h"
+#include "IndexedHeap.h"
+
+
+namespace paths
+{
+	/**
+	 * Scratch state of one search direction: best cost and parent edge per node, the closed set and the
+	 * frontier, an indexed heap holding every open node once. A context belongs to one thread at a time,
+	 * Pathfinder keeps a pair for the interactive searches and every batch worker has its own.
+	 *
+	 * The buffers are kept between searches (an arena reused on every run), so a search costs no allocation
+	 * once they reached the size of the graph. Per-node entries are only valid if their stamp matches the
+	 * current generation, which makes reset() O(1) instead of O(nodes). The closed set has a generation of
+	 * its own, so reopen() can empty it in O(1) while costs, parents and the frontier stay.
+	 */
+	class SearchContext
+	{
+	public:
+		static constexpr uint32_t NO_EDGE = UINT32_MAX;
+		static constexpr double INF = std::numeric_limits<double>::infinity();
+
+		using frontier = IndexedHeap<4>;
+		using entry = frontier::entry;
+
+		/**
+		 * Starts a new search over a graph of the given size.
+		 */
+		void reset(size_t nodes)
+		{
+			if (stamps.size() != nodes)
+			{
+				stamps.assign(nodes, 0);
+				closedStamps.assign(nodes, 0);
+				costs.resize(nodes);
+				parents.resize(nodes);
+				generation = 0;
+				closedGeneration = 0;
+			}
+
+			// Once every 2^32 searches the stamps wrap around and have to be wiped for real
+			if (++generation == 0)
+			{
+				std::fill(stamps.begin(), stamps.end(), 0);
+				generation = 1;
+			}
+
+			reopen();
+			heap.reset(nodes);
+			relaxations = 0;
+		}
+
+		/**
+		 * Empties the closed set only, for searches that expand nodes again with what they already know (ARA*).
+		 */
+		void reopen()
+		{
+			if (++closedGeneration == 0)
+			{
+				std::fill(closedStamps.begin(), closedStamps.end(), 0);
+				closedGeneration = 1;
+			}
+		}
+
+		double cost(uint32_t node) const { return stamps[node] == generation ? costs[node] : INF; }
+		uint32_t parent(uint32_t node) const { return stamps[node] == generation ? parents[node] : NO_EDGE; }
+
+		void relax(uint32_t node, double cost, uint32_t edge)
+		{
+			stamps[node] = generation;
+			costs[node] = cost;
+			parents[node] = edge;
+			++relaxations;
+		}
+
+		bool closed(uint32_t node) const { return closedStamps[node] == closedGeneration; }
+		void close(uint32_t node) { closedStamps[node] = closedGeneration; }
+
+		/*
+
+		Frontier, pushing an open node again only lowers its key
+
+		*/
+		bool push(double key, uint32_t node) { return heap.push(key, node); }
+		entry pop() { return heap.pop(); }
+		entry const& top() const { return heap.top(); }
+		bool empty() const { return heap.empty(); }
+		template<class KeyOf>
+		void rekey(KeyOf&& key_of) { heap.rekey(key_of); }
+		size_t size() const { return heap.size(); }
+		frontier::counters const& getCounters() const { return heap.getCounters(); }
+
+		// Costs set since reset(), the start included
+		size_t getRelaxations() const { return relaxations; }
+
+	private:
+		std::vector<uint32_t> stamps;
+		std::vector<uint32_t> closedStamps;
+		std::vector<double> costs;
+		std::vector<uint32_t> parents;
+		frontier heap;
+		uint32_t generation = 0;
+		uint32_t closedGeneration = 0;
+		size_t relaxations = 0;
+	};
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include "PathTypes.h"
+
+
+namespace paths
+{
+	/**
+	 * Phases of a route request, timed separately by Pathfinder::pathfind.
+	 */
+	enum class SearchPhase : char
+	{
+		LOOKUP,				// Centers of Interest -> places
+		GRAPH,				// graph load, live changes, landmarks
+		SEARCH,
+		RECONSTRUCTION,		// parent edges -> path legs
+		INJECTION,			// "inject_route" and reading the stored route back
+		COUNT
+	};
+
+	inline const char* phaseName(SearchPhase phase)
+	{
+		switch (phase)
+		{
+		case SearchPhase::LOOKUP: return "lookup";
+		case SearchPhase::GRAPH: return "graph";
+		case SearchPhase::SEARCH: return "search";
+		case SearchPhase::RECONSTRUCTION: return "reconstruction";
+		case SearchPhase::INJECTION: return "injection";
+		default: return "unknown";
+		}
+	}
+
+	inline const char* modeName(SearchMode mode)
+	{
+		switch (mode)
+		{
+		case SearchMode::UNIDIRECTIONAL: return "unidirectional";
+		case SearchMode::BIDIRECTIONAL: return "bidirectional";
+		case SearchMode::CONTRACTION_HIERARCHY: return "hierarchy";
+		case SearchMode::PARETO: return "pareto";
+		case SearchMode::ANYTIME: return "anytime";
+		case SearchMode::ALTERNATIVES: return "alternatives";
+		default: return "unknown";
+		}
+	}
+
+	/**
+	 * What the last route request cost, see Pathfinder::getLastStats().
+	 *
+	 * The frontier counters are only filled by the A* modes (unidirectional, bidirectional, anytime), frontierCounted
+	 * tells them apart from a search that pushed nothing; the other modes report the places (or labels) they expanded.
+	 * Round trips and bytes are the ones made through the query:: helpers (see query::traffic), bytes count field values only.
+	 */
+	struct searchStats
+	{
+		static constexpr size_t PHASES = static_cast<size_t>(SearchPhase::COUNT);
+
+		SearchMode mode = SearchMode::UNIDIRECTIONAL;
+		bool cached = false;				// served from the route cache, nothing was searched
+		bool frontierCounted = false;
+
+		size_t expanded = 0;
+		size_t pushes = 0;
+		size_t duplicatePushes = 0;			// pushes of a place already queued, they only lower its key
+		size_t pops = 0;
+		size_t relaxed = 0;					// connections that lowered the cost of the place they lead to
+
+		uint64_t roundTrips = 0;
+		uint64_t bytesReceived = 0;
+
+		double phaseMs[PHASES] = {};
+
+		double& time(SearchPhase phase) { return phaseMs[static_cast<size_t>(phase)]; }
+		double time(SearchPhase phase) const { return phaseMs[static_cast<size_t>(phase)]; }
+
+		double totalMs() const
+		{
+			double total = 0.0;
+			for (auto const ms : phaseMs)
+				total += ms;
+			return total;
+		}
+
+		/**
+		 * One "key=value" line with every field, the keys never change between releases so the lines can be collected and compared.
+		 */
+		std::string toRecord() const
+		{
+			std::stringstream record;
+			record << "pathfinder-stats mode=" << modeName(mode) << " cached=" << cached << " frontier_counted=" << frontierCounted
+				<< " expanded=" << expanded << " pushes=" << pushes << " duplicate_pushes=" << duplicatePushes << " pops=" << pops
+				<< " relaxed=" << relaxed << " round_trips=" << roundTrips << " bytes_received=" << bytesReceived;
+
+			for (size_t phase = 0; phase < PHASES; ++phase)
+				record << " " << phaseName(static_cast<SearchPhase>(phase)) << "_ms=" << phaseMs[phase];
+
+			record << " total_ms=" << totalMs();
+			return record.str();
+		}
+	};
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+
+namespace paths
+{
+	/*
+
+	On-disk layout of a GraphSnapshot, little-endian and in the native layout of the arrays, so that a mapped
+	file is used in place:
+
+	    snapshotHeader
+	    one section per GraphSnapshot array, each starting on a SNAPSHOT_ALIGNMENT boundary
+
+	The landmark tables of the ALT heuristic (see LandmarkTable.h) travel with the graph, they are empty when
+	the file was written without them.
+
+	The header records the "ConnectionVersion" the graph was taken at, a file older than the DB is rewritten.
+	Any change of the layout must bump SNAPSHOT_FORMAT, older files are then just ignored and rebuilt.
+
+	*/
+
+	constexpr char SNAPSHOT_MAGIC[8] = { 'D', 'B', 'G', 'R', 'A', 'P', 'H', '\0' };
+	constexpr uint32_t SNAPSHOT_FORMAT = 2;
+	constexpr size_t SNAPSHOT_ALIGNMENT = 64;
+
+	enum snapshotSection : uint32_t
+	{
+		SECTION_IDS,				// int64_t per node, its Place ID
+		SECTION_INDEX,				// placeIndex per node, sorted by Place ID
+		SECTION_OFFSETS,			// uint32_t per node + 1
+		SECTION_SOURCES,			// uint32_t per edge
+		SECTION_TARGETS,			// uint32_t per edge
+		SECTION_DISTANCES,			// double per edge
+		SECTION_FEES,				// double per edge
+		SECTION_VEHICLES,			// uint8_t per edge, a VehicleType
+		SECTION_REVERSE_OFFSETS,	// uint32_t per node + 1
+		SECTION_REVERSE_EDGES,		// uint32_t per edge
+		SECTION_XS,					// double per node
+		SECTION_YS,					// double per node
+		SECTION_LANDMARKS,			// uint32_t per landmark, its dense node index
+		SECTION_LANDMARK_FROM,		// double per node and landmark, node-major
+		SECTION_LANDMARK_TO,		// double per node and landmark, node-major
+		SECTION_COUNT
+	};
+
+	struct sectionExtent
+	{
+		uint64_t offset;	// from the start of the file
+		uint64_t bytes;
+	};
+
+	struct snapshotHeader
+	{
+		char magic[8];
+		uint32_t format;
+		uint32_t headerBytes;		// sizeof(snapshotHeader) of the writer
+		int64_t graphVersion;
+		uint64_t nodes;
+		uint64_t edges;
+		uint64_t landmarks;
+		uint64_t checksum;			// FNV-1a over every byte after the header
+		sectionExtent sections[SECTION_COUNT];
+	};
+
+	/**
+	 * 64 bit FNV-1a, chained through hash so a file can be hashed piece by piece.
+	 */
+	inline uint64_t fnv1a(void const* data, size_t bytes, uint64_t hash = 14695981039346656037ull)
+	{
+		auto const* p = static_cast<uint8_t const*>(data);
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			hash ^= p[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
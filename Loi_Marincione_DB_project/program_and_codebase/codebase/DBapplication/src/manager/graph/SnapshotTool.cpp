@@ -0,0 +1,226 @@
+#include "SnapshotTool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "GraphSnapshot.h"
+#include "../../DButils/queries.h"
+
+
+namespace paths
+{
+	namespace
+	{
+		void usage()
+		{
+			std::cerr << "Usage:\n"
+				<< "  DBapplication --snapshot build <file> [--csv <connections.csv> [--places <Place dump>]] [--version <n>] [--landmarks <n>]\n"
+				<< "  DBapplication --snapshot verify <file> [--db]" << std::endl;
+		}
+
+		bool readConnections(std::string const& file, std::vector<connectionRow>& rows)
+		{
+			std::ifstream in(file);
+			if (!in)
+			{
+				std::cerr << "Could not open " << file << "!" << std::endl;
+				return false;
+			}
+
+			std::string line;
+			std::getline(in, line);	// AllowedVehicles,PlaceA,PlaceB,fee,distance
+
+			for (size_t number = 2; std::getline(in, line); ++number)
+			{
+				if (line.empty() || line == "\r")
+					continue;
+
+				std::stringstream fields(line);
+				std::string vehicle, from, to, fee, distance;
+
+				if (!(std::getline(fields, vehicle, ',') && std::getline(fields, from, ',') && std::getline(fields, to, ',')
+					&& std::getline(fields, fee, ',') && std::getline(fields, distance)))
+				{
+					std::cerr << "Line " << number << " of " << file << " is not a valid Connection row!" << std::endl;
+					return false;
+				}
+
+				// "real" columns, rounded through float like the DB load so verify --db compares equal values
+				rows.push_back({ _strtoi64(from.c_str(), nullptr, 10), _strtoi64(to.c_str(), nullptr, 10), toVehicle(vehicle),
+					static_cast<float>(std::stod(fee)), static_cast<float>(std::stod(distance)) });
+			}
+
+			return true;
+		}
+
+		bool readPlaces(std::string const& file, std::vector<placeRow>& rows)
+		{
+			std::ifstream in(file);
+			if (!in)
+			{
+				std::cerr << "Could not open " << file << "!" << std::endl;
+				return false;
+			}
+
+			// COPY text format: ID <tab> (x,y) <tab> Name, closed by "\."
+			std::string line;
+			for (size_t number = 1; std::getline(in, line); ++number)
+			{
+				if (line.empty() || line.rfind("\\.", 0) == 0)
+					continue;
+
+				size_t open = line.find('(');
+				size_t comma = line.find(',', open);
+				if (open == std::string::npos || comma == std::string::npos)
+				{
+					std::cerr << "Line " << number << " of " << file << " is not a valid Place row!" << std::endl;
+					return false;
+				}
+
+				rows.push_back({ _strtoi64(line.c_str(), nullptr, 10), std::stod(line.substr(open + 1)), std::stod(line.substr(comma + 1)) });
+			}
+
+			return true;
+		}
+
+		int build(std::string const& file, std::vector<std::string> const& options, std::string const& conninfo)
+		{
+			std::string csv;
+			std::string places;
+			int64_t version = 0;
+			bool versionGiven = false;
+			size_t landmarks = LandmarkTable::DEFAULT_COUNT;
+
+			for (size_t i = 0; i + 1 < options.size(); i += 2)
+			{
+				if (options[i] == "--csv") csv = options[i + 1];
+				else if (options[i] == "--places") places = options[i + 1];
+				else if (options[i] == "--version") { version = _strtoi64(options[i + 1].c_str(), nullptr, 10); versionGiven = true; }
+				else if (options[i] == "--landmarks") landmarks = static_cast<size_t>(std::max<int64_t>(0, _strtoi64(options[i + 1].c_str(), nullptr, 10)));
+				else { usage(); return 1; }
+			}
+
+			if (options.size() % 2 != 0 || (!places.empty() && csv.empty()))
+			{
+				usage();
+				return 1;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			GraphSnapshot graph;
+
+			if (!csv.empty())
+			{
+				std::vector<placeRow> place_rows;
+				std::vector<connectionRow> connection_rows;
+
+				if (!readConnections(csv, connection_rows) || (!places.empty() && !readPlaces(places, place_rows)))
+					return 1;
+
+				graph.assign(place_rows, connection_rows);
+			}
+			else
+			{
+				PGconn* conn = query::connect(conninfo.c_str());
+				int64_t current = 0;
+
+				// Read before loading, like the pathfinder does: a change landing in between makes the file look stale, never current
+				if (!readConnectionVersion(conn, current))
+					std::cerr << "The \"ConnectionVersion\" sequence is missing, the pathfinder will not use this snapshot." << std::endl;
+
+				bool loaded = graph.load(conn);
+				PQfinish(conn);
+
+				if (!loaded)
+					return 1;
+
+				if (!versionGiven)
+					version = current;
+			}
+
+			graph.placeLandmarks(landmarks);
+
+			if (!graph.save(file, version))
+				return 1;
+
+			auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			std::cout << " Wrote " << file << ": " << graph.nodeCount() << " places, " << graph.edgeCount() << " connections, "
+				<< graph.getLandmarks().size() << " landmarks, version " << version << " (" << elapsed << " ms)" << std::endl;
+			return 0;
+		}
+
+		int verify(std::string const& file, std::vector<std::string> const& options, std::string const& conninfo)
+		{
+			bool against_db = false;
+			for (auto const& option : options)
+			{
+				if (option != "--db") { usage(); return 1; }
+				against_db = true;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			GraphSnapshot graph;
+			int64_t version = 0;
+
+			if (!graph.map(file, version, true))
+			{
+				std::cerr << " " << file << " could not be opened as a graph snapshot." << std::endl;
+				return 1;
+			}
+
+			std::string problem;
+			if (!graph.validate(problem))
+			{
+				std::cerr << " " << file << " is inconsistent: " << problem << "." << std::endl;
+				return 1;
+			}
+
+			auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			std::cout << " " << file << " is valid: " << graph.nodeCount() << " places, " << graph.edgeCount() << " connections, "
+				<< graph.getLandmarks().size() << " landmarks, version " << version << " (checked in " << elapsed << " ms)" << std::endl;
+
+			if (!against_db)
+				return 0;
+
+			PGconn* conn = query::connect(conninfo.c_str());
+			int64_t current = 0;
+			bool known = readConnectionVersion(conn, current);
+
+			GraphSnapshot live;
+			bool loaded = live.load(conn);
+			PQfinish(conn);
+
+			if (!loaded)
+				return 1;
+
+			bool same = graph.sameAs(live);
+			std::cout << " Against the DB (version " << (known ? std::to_string(current) : std::string("unknown")) << "): "
+				<< (same ? "same graph" : "different graph") << ", "
+				<< (known && current == version ? "the pathfinder will use it" : "the pathfinder will rebuild it") << "." << std::endl;
+
+			return same ? 0 : 1;
+		}
+	}
+
+	int snapshotTool(int argc, char** argv, std::string const& conninfo)
+	{
+		if (argc < 2)
+		{
+			usage();
+			return 1;
+		}
+
+		std::string const command = argv[0];
+		std::string const file = argv[1];
+		std::vector<std::string> const options(argv + 2, argv + argc);
+
+		if (command == "build")
+			return build(file, options, conninfo);
+		if (command == "verify")
+			return verify(file, options, conninfo);
+
+		usage();
+		return 1;
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+
+
+namespace paths
+{
+	/**
+	 * Command line front end for graph snapshot files, run as "DBapplication --snapshot <command> ...":
+	 *
+	 *     build <file> [--csv <connections.csv> [--places <Place dump>]] [--version <n>]
+	 *         Writes a snapshot of the live DB, or of a "Connection" CSV export (AllowedVehicles,PlaceA,PlaceB,fee,distance)
+	 *         plus optionally the COPY data of "Place" (ID, tab, (x,y), ...). A CSV snapshot is stamped with --version, 0 by default.
+	 *
+	 *     verify <file> [--db]
+	 *         Checks the checksum and every CSR invariant, and with --db compares the file with the live DB.
+	 *
+	 * \param conninfo  Connection string used for the commands that talk to the DB.
+	 * \return          Exit code, 0 on success.
+	 */
+	int snapshotTool(int argc, char** argv, std::string const& conninfo);
+}
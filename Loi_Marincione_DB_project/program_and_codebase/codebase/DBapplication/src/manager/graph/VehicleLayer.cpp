@@ -0,0 +1,67 @@
+#include "VehicleLayer.h"
+
+
+namespace paths
+{
+	void VehicleLayer::build(GraphSnapshot const& graph, char allowed_vehicles)
+	{
+		clear();
+		allowed = allowed_vehicles & ALL_VEHICLES;
+
+		uint32_t const nNodes = static_cast<uint32_t>(graph.nodeCount());
+		uint8_t const mask = static_cast<uint8_t>(allowed);
+
+		offsets.assign(nNodes + 1, 0);
+		rOffsets.assign(nNodes + 1, 0);
+
+		// Sized for every edge, the cursor only moves past the allowed ones
+		edges.resize(graph.edgeCount());
+		rEdges.resize(graph.edgeCount());
+
+		uint32_t kept = 0;
+		uint32_t rKept = 0;
+
+		for (uint32_t u = 0; u < nNodes; ++u)
+		{
+			offsets[u] = kept;
+			for (uint32_t edge = graph.edgesBegin(u); edge < graph.edgesEnd(u); ++edge)
+			{
+				edges[kept] = edge;
+				kept += (graph.vehicle(edge) & mask) != 0;
+			}
+
+			rOffsets[u] = rKept;
+			for (uint32_t i = graph.inBegin(u); i < graph.inEnd(u); ++i)
+			{
+				uint32_t const edge = graph.inEdge(i);
+				rEdges[rKept] = edge;
+				rKept += (graph.vehicle(edge) & mask) != 0;
+			}
+		}
+
+		offsets[nNodes] = kept;
+		rOffsets[nNodes] = rKept;
+
+		edges.resize(kept);
+		edges.shrink_to_fit();
+		rEdges.resize(rKept);
+		rEdges.shrink_to_fit();
+
+		built = true;
+	}
+
+	void VehicleLayer::clear()
+	{
+		std::vector<uint32_t>().swap(offsets);
+		std::vector<uint32_t>().swap(edges);
+		std::vector<uint32_t>().swap(rOffsets);
+		std::vector<uint32_t>().swap(rEdges);
+		allowed = 0;
+		built = false;
+	}
+
+	size_t VehicleLayer::memoryBytes() const
+	{
+		return (offsets.capacity() + edges.capacity() + rOffsets.capacity() + rEdges.capacity()) * sizeof(uint32_t);
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "PathTypes.h"
+#include "GraphSnapshot.h"
+
+
+namespace paths
+{
+	/**
+	 * The part of a GraphSnapshot a set of vehicles can travel on: for every place, the IDs of its outgoing
+	 * and incoming edges whose vehicle is in the mask, in the same order as in the snapshot.
+	 *
+	 * Searches walk the layer instead of the full adjacency, so edges of a forbidden vehicle are never
+	 * looked at and the relaxation loops need no vehicle test at all. Building is a single branch-free
+	 * compaction pass over the edge arrays: every edge is written, and only kept by advancing the cursor.
+	 */
+	class VehicleLayer
+	{
+	public:
+		void build(GraphSnapshot const& graph, char allowed_vehicles);
+		void clear();
+
+		bool isBuilt() const { return built; }
+		char getAllowedVehicles() const { return allowed; }
+
+		uint32_t outBegin(uint32_t node) const { return offsets[node]; }
+		uint32_t outEnd(uint32_t node) const { return offsets[node + 1]; }
+		uint32_t outEdge(uint32_t i) const { return edges[i]; }
+
+		uint32_t inBegin(uint32_t node) const { return rOffsets[node]; }
+		uint32_t inEnd(uint32_t node) const { return rOffsets[node + 1]; }
+		uint32_t inEdge(uint32_t i) const { return rEdges[i]; }
+
+		size_t edgeCount() const { return edges.size(); }
+		size_t memoryBytes() const;
+
+	private:
+		std::vector<uint32_t> offsets;		// nodeCount() + 1 entries
+		std::vector<uint32_t> edges;		// snapshot edge IDs grouped by source
+		std::vector<uint32_t> rOffsets;		// nodeCount() + 1 entries
+		std::vector<uint32_t> rEdges;		// snapshot edge IDs grouped by target
+
+		char allowed = 0;
+		bool built = false;
+	};
+}
@@ -25,6 +25,7 @@ public:
 		strbuild << "\b\b  \b\b)" << color::RESET;
 
 		parsed_name = strbuild.str();
+		compileCall();
 	}
 
 	explicit Function(const char* func_name, const char* c_name, std::array<string_tup, S> const& argnames) : argn(argnames)
@@ -43,6 +44,7 @@ public:
 		strbuild << "\b\b  \b\b)" << color::RESET;
 
 		parsed_name = strbuild.str();
+		compileCall();
 	}
 
 	void setParams(std::array<std::string, S> const& params)
@@ -64,7 +66,7 @@ public:
 		return true;
 	}
 
-	void execute(PGresult*& res, PGconn*& conn) override
+	void execute(PGresult*& res, query::preparedStatements& statements) override
 	{
 
 		std::cout << " Executing Function " << parsed_name << ", Awaiting user input : \n\n";
@@ -80,20 +82,7 @@ public:
 		}
 		std::cout << "\n";
 
-		std::stringstream query;
-		query << "SELECT * FROM \"" + call_name + "\"(";
-
-		for (auto const& par : args)
-		{
-			query << "\'" << par << "\'" << ", ";
-		}
-
-		query << ")";
-
-		std::string query_built = query.str();
-		query_built.erase(query_built.size() - 3, 2);
-
-		if (query::atomicQuery(query_built.c_str(), res, conn))
+		if (statements.execute(getStatement(), std::vector<std::string>(args.begin(), args.end()), res))
 			std::cout << " Function \"" << parsed_name << "\" correctly executed!" << "\n";
 
 
@@ -104,6 +93,18 @@ public:
 	std::string_view getContent() override { assert(false, "Functions are content-less"); return " "; }
 
 private:
+	/**
+	 * Builds the SELECT over the function once, the arguments are its parameters.
+	 */
+	void compileCall()
+	{
+		std::string sql = "SELECT * FROM \"" + call_name + "\"(";
+		for (std::size_t i = 0; i < S; ++i)
+			sql += (i ? ", $" : "$") + std::to_string(i + 1);
+		sql += ")";
+
+		compile(std::move(sql), static_cast<int>(S));
+	}
 
 	std::array<string_tup, S> argn;
 	std::array<std::string, S> args;
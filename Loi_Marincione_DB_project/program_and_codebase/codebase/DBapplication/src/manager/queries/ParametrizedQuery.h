@@ -1,9 +1,13 @@
 #pragma once
 #include "WKQuery.h"
-#include <queue>
+#include <vector>
 #include "..\..\DButils\queries.h"
 
 
+/**
+ * A query whose values are marked with % in content, they are asked for every time it runs.
+ * Every % becomes a $n parameter when the query is registered, the values never become part of the SQL text.
+ */
 class ParametrizedQuery : public WKQuery
 {
 public:
@@ -12,54 +16,34 @@ public:
 	{
 		name = query_name;
 		content = query_content;
-		parsed_query = query::parseQuery(content);
+		compileParameters();
 	}
 
 	ParametrizedQuery(const char* query_name, const char* query_content)
 	{
 		name = query_name;
 		content = query_content;
-		parsed_query = query::parseQuery(content);
+		compileParameters();
 	}
 
 	bool hasArgs() override {
 		return false;
 	}
 
-	void execute(PGresult*& res, PGconn*& conn) override
+	void execute(PGresult*& res, query::preparedStatements& statements) override
 	{
 		std::cout << "\n" << " Executing Parametrized Query " << color::FIELD << name << color::RESET << ": " << "\n" << "\t" << parsed_query << "\n";
-		
-		std::stringstream querybuilder;
 
-		std::queue<std::string> split_str;
+		std::vector<std::string> values(paramCount);
 
-		size_t last = 0;
-		size_t next = 0;
-		while ((next = content.find('%', last)) != std::string::npos)
+		for (int n_param = 0; n_param < paramCount; ++n_param)
 		{
-			split_str.emplace(content.substr(last, next - last));
-			last = next + 1;
-		}
-		split_str.emplace(content.substr(last));
-
-		querybuilder << split_str.front(); split_str.pop();
-
-		std::string parameter;
-
-		for (size_t n_param = 1; !split_str.empty(); split_str.pop())
-		{
-			std::cout << " Insert Query Parameter " << n_param++ << std::endl;
-			std::cout << "\t" << query::parseQuery(querybuilder.str());
-			std::cin >> parameter;
+			std::cout << " Insert Query Parameter " << n_param + 1 << " ($" << n_param + 1 << ")" << std::endl;
+			std::cin >> values[n_param];
 			std::cout << '\b' << "\33[2K\r";
-
-			querybuilder << " \'" << parameter << "\' " << split_str.front();
 		}
 
-		std::cout << " Final query is:\n" << query::parseQuery(querybuilder.str()) << std::endl;
-
-		if (!(query::atomicQuery(querybuilder.str().c_str(), res, conn)))
+		if (!statements.execute(getStatement(), values, res))
 		{
 			std::cerr << "Parametrized query execution went wrong!" << std::endl;
 			return;
@@ -70,7 +54,25 @@ public:
 	}
 
 private:
+	/**
+	 * Numbers the % markers of content into $1..$n.
+	 */
+	void compileParameters()
+	{
+		std::string sql;
+		int count = 0;
+
+		for (char const c : content)
+		{
+			if (c == '%')
+				sql += "$" + std::to_string(++count);
+			else
+				sql += c;
+		}
+
+		parsed_query = query::parseQuery(sql);
+		compile(std::move(sql), count);
+	}
+
 	std::string parsed_query;
 };
-
-#pragma once
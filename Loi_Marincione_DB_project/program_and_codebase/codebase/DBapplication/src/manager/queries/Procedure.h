@@ -29,6 +29,7 @@ public:
 		strbuild << "\b\b  \b\b)" << color::RESET;
 
 		parsed_name = strbuild.str();
+		compileCall();
 	}
 
 	Procedure(const char* proc_name, const char* c_name, std::array<string_tup, S> const& argnames) : argn(argnames)
@@ -47,6 +48,7 @@ public:
 		strbuild << "\b\b  \b\b)" << color::RESET;
 
 		parsed_name = strbuild.str();
+		compileCall();
 	}
 
 	void setParams(std::array<std::string, S> const& params)
@@ -68,7 +70,7 @@ public:
 		return true;
 	}
 
-	void execute(PGresult*& res, PGconn*& conn) override 
+	void execute(PGresult*& res, query::preparedStatements& statements) override 
 	{
 
 		std::cout << " Executing Procedure " << parsed_name << ", Awaiting user input : \n\n";
@@ -84,20 +86,7 @@ public:
 		}
 		std::cout << "\n";
 
-		std::stringstream query;
-		query << "CALL \"" + call_name + "\"(";
-
-		for (auto const& par : args)
-		{
-			query << '\'' << par + "\', ";
-		}
-
-		query << ")";
-
-		std::string query_built = query.str();
-		query_built.erase(query_built.size() - 3, 2);
-
-		if (query::atomicQuery(query_built.c_str(), res, conn))
+		if (statements.execute(getStatement(), std::vector<std::string>(args.begin(), args.end()), res))
 			std::cout << "\n Procedure \"" << parsed_name << "\" correctly executed!" << "\n";
 	}
 
@@ -105,6 +94,18 @@ public:
 	std::string_view getContent() override { assert(false, "Procedures are content-less"); return " "; }
 
 private:
+	/**
+	 * Builds the CALL statement once, the arguments are its parameters.
+	 */
+	void compileCall()
+	{
+		std::string sql = "CALL \"" + call_name + "\"(";
+		for (std::size_t i = 0; i < S; ++i)
+			sql += (i ? ", $" : "$") + std::to_string(i + 1);
+		sql += ")";
+
+		compile(std::move(sql), static_cast<int>(S));
+	}
 
 	std::array<string_tup, S> argn;
 	std::array<std::string, S> args;
@@ -13,6 +13,7 @@ public:
 		name = query_name;
 		content = query_content;
 		parsed_query = query::parseQuery(content);
+		compile(content, 0);
 	}
 
 	Query(const char* query_name, const char* query_content)
@@ -20,16 +21,17 @@ public:
 		name = query_name;
 		content = query_content;
 		parsed_query = query::parseQuery(content);
+		compile(content, 0);
 	}
 
 	bool hasArgs() override {
 		return false;
 	}
 
-	void execute(PGresult*& res, PGconn*& conn) override
+	void execute(PGresult*& res, query::preparedStatements& statements) override
 	{
 		std::cout << "\n" << "Executing Query " << color::FIELD << name << color::RESET << ": " << "\n" << "\t" << parsed_query << "\n";
-		query::atomicQuery(content.c_str(), res, conn);
+		statements.execute(getStatement(), {}, res);
 
 		printer.printTable(res);
 	}
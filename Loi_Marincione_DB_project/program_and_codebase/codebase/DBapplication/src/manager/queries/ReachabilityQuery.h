@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "WKQuery.h"
+#include "..\Pathfinder.h"
+#include "..\..\defines\clicolors.h"
+
+
+/**
+ * Well Known entry answering "which places can this Center of Interest reach within a budget", computed
+ * by the pathfinder on its in-memory graph instead of the DB (see Pathfinder::reachable).
+ */
+class ReachabilityQuery : public WKQuery
+{
+public:
+
+	ReachabilityQuery(std::string_view query_name, Pathfinder& pathfinder) : pather(pathfinder)
+	{
+		name = query_name;
+		content = "Places reachable from a Center of Interest within a distance or total fee";
+	}
+
+	bool hasArgs() override {
+		return true;
+	}
+
+	// The registry goes unused: the pathfinder resolves the Center of Interest through its own
+	void execute(PGresult*& res, query::preparedStatements&) override
+	{
+		// Nothing is fetched from the DB here, the caller clears res afterwards
+		res = nullptr;
+
+		std::string coi;
+		std::string metric;
+		std::string budget;
+		std::string vehicles;
+		paths::pathOptions options;
+
+		std::cout << " Executing " << color::FUNCTION << name << color::RESET << ", Awaiting user input : \n\n";
+		std::cout << " Center of Interest : int: ";
+		std::cin >> coi;
+		std::cout << " Budget on (distance/fee) : text: ";
+		std::cin >> metric;
+		std::cout << " Maximum " << metric << " : double: ";
+		std::cin >> budget;
+		std::cout << " Allowed vehicles, sum of 1: Plane, 2: Ship, 4: Car (default: all of them) : int: ";
+		std::cin >> vehicles;
+		std::cout << "\n";
+
+		if (vehicles != "default") {
+			options.allowedVehicles = (char) (_strtoi64(vehicles.c_str(), nullptr, 10) & paths::ALL_VEHICLES);
+		}
+
+		paths::ReachMetric const by = (metric == "fee") ? paths::ReachMetric::FEE : paths::ReachMetric::DISTANCE;
+
+		std::vector<paths::reachablePlace> places;
+		if (!pather.reachable(_strtoi64(coi.c_str(), nullptr, 10), by, std::strtod(budget.c_str(), nullptr), options, places))
+			return;
+
+		std::cout << " " << color::FIELD << "Place\tDistance\tFee\tLegs\tVehicles" << color::RESET << "\n";
+
+		size_t const shown = std::min(places.size(), SHOWN_ROWS);
+		for (size_t i = 0; i < shown; ++i)
+		{
+			auto const& place = places[i];
+			std::cout << " " << place.place << "\t" << place.distance << "\t" << place.fee << "\t" << place.legs << "\t" << vehicleMix(place.vehicles) << "\n";
+		}
+
+		if (places.size() > shown)
+			std::cout << " ... and " << places.size() - shown << " farther places\n";
+
+		std::cout << "\n " << places.size() << " places reachable." << std::endl;
+	}
+
+private:
+
+	static std::string vehicleMix(char vehicles)
+	{
+		std::string mix;
+		if (vehicles & paths::PLANE) mix += "Plane ";
+		if (vehicles & paths::SHIP) mix += "Ship ";
+		if (vehicles & paths::CAR) mix += "Car ";
+		return mix.empty() ? "-" : mix;
+	}
+
+	// Rows printed, the count covers the rest
+	static constexpr size_t SHOWN_ROWS = 200;
+
+	Pathfinder& pather;
+};
@@ -3,11 +3,18 @@
 #include <string_view>
 #include <libpq-fe.h>
 #include "..\..\DButils\CLprinter.h"
+#include "..\..\DButils\PreparedStatements.h"
 
 class WKQuery
 {
 public:
-	virtual void execute(PGresult*& res, PGconn*& conn) = 0;
+	/**
+	 * Runs the query, prompting for its values if it takes any.
+	 *
+	 * \param res         Receives the results, the caller clears it.
+	 * \param statements  Registry of the connection the query runs on, it prepares the compiled statement on first use.
+	 */
+	virtual void execute(PGresult*& res, query::preparedStatements& statements) = 0;
 	virtual ~WKQuery() = default;
 
 	virtual std::string_view getName() { return name; }
@@ -16,8 +23,27 @@ public:
 	virtual bool hasArgs() { return false; }
 
 protected:
+	/**
+	 * Sets the statement the query runs, once when it is registered: sql takes its values as $1..$param_count,
+	 * so running it again only binds new values to the plan the server already has.
+	 */
+	void compile(std::string sql, int param_count)
+	{
+		statementName = "wk_" + std::to_string(++compiled);
+		statementSql = std::move(sql);
+		paramCount = param_count;
+	}
+
+	query::statement getStatement() const { return { statementName.c_str(), statementSql.c_str(), paramCount }; }
+
 	std::string name;
 	std::string content;
 	CLprinter printer;
-};
 
+	std::string statementName;
+	std::string statementSql;
+	int paramCount = 0;
+
+private:
+	static inline int compiled = 0;	// statements compiled so far, numbers their names
+};